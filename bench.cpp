@@ -0,0 +1,800 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <iomanip>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "classes.cpp"
+#include "grammar_rules.cpp"
+#include "vm.cpp"
+#include "parallel.cpp"
+#include "generated_parser.hpp"
+#include "incremental.cpp"
+#include "workload.cpp"
+
+using namespace std;
+
+// Benchmarks del parser. Compilar con:
+//   g++ -std=c++17 -O2 -pthread bench.cpp -o bench
+// Uso:
+//   ./bench [--json] [--tokens N] [--depth N] [--errors P] [--seed N] [--nonterms N]
+// Los programas se generan a partir de la gramatica (workload.cpp). Con --json
+// se imprime la configuracion y todas las metricas para comparar corridas.
+
+using Clock = chrono::steady_clock;
+
+static double secondsSince(Clock::time_point t0) {
+    return chrono::duration<double>(Clock::now() - t0).count();
+}
+
+struct BenchConfig {
+    size_t tokens = 2000000;    // tamano de los programas generados
+    int depth = 8;              // anidamiento maximo de parentesis
+    double errorRate = 0.01;    // mutaciones por token en el programa invalido
+    unsigned seed = 42;
+    int nonTerms = 2000;        // tamano de la gramatica sintetica
+    string cacheDir = "/tmp";   // donde se escriben las gramaticas compiladas
+    bool json = false;
+};
+
+// Metricas de una corrida, agrupadas por seccion en el orden en que se agregan
+class BenchReport {
+    private:
+        struct Metric {
+            string section;
+            string name;
+            double value;
+            string unit;
+        };
+        vector<Metric> metrics;
+
+        static string quoted(const string &s) {
+            string out = "\"";
+            for (char c : s) {
+                if (c == '"' || c == '\\') out += '\\';
+                out += c;
+            }
+            return out + "\"";
+        }
+
+    public:
+        void add(const string &section, const string &name, double value, const string &unit) {
+            metrics.push_back({section, name, value, unit});
+        }
+
+        void printText(ostream &out) const {
+            string section;
+            for (const Metric &m : metrics) {
+                if (m.section != section) {
+                    section = m.section;
+                    out << section << ":" << endl;
+                }
+                out << "  " << left << setw(32) << m.name << " " << m.value << " " << m.unit << endl;
+            }
+        }
+
+        void printJson(ostream &out, const BenchConfig &cfg, uint64_t fingerprint) const {
+            out << "{\n";
+            out << "  \"grammar_fingerprint\": \"0x" << hex << fingerprint << dec << "\",\n";
+            out << "  \"config\": {\"tokens\": " << cfg.tokens << ", \"depth\": " << cfg.depth
+                << ", \"error_rate\": " << cfg.errorRate << ", \"seed\": " << cfg.seed
+                << ", \"nonterms\": " << cfg.nonTerms << "},\n";
+            out << "  \"metrics\": [\n";
+            for (size_t i = 0; i < metrics.size(); i++) {
+                const Metric &m = metrics[i];
+                out << "    {\"section\": " << quoted(m.section) << ", \"name\": " << quoted(m.name)
+                    << ", \"value\": " << setprecision(10) << m.value << ", \"unit\": " << quoted(m.unit) << "}"
+                    << (i + 1 < metrics.size() ? "," : "") << "\n";
+            }
+            out << "  ]\n}" << endl;
+        }
+};
+
+static GeneratedProgram generateWorkload(const BenchConfig &cfg, unsigned seed, double errorRate) {
+    Grammar grammar(generateGrammarRules());
+    ProgramGenerator generator(grammar, seed);
+    WorkloadOptions options;
+    options.targetTokens = cfg.tokens;
+    options.maxDepth = cfg.depth;
+    options.errorRate = errorRate;
+    return generator.generate(options);
+}
+
+static vector<Token::Type> scanAll(const string &program) {
+    Scanner scanner{string_view(program)};
+    vector<Token::Type> types;
+    while (true) {
+        Token tok = scanner.nextToken();
+        types.push_back(tok.type);
+        if (tok.type == Token::END) break;
+    }
+    return types;
+}
+
+// Parseo completo como lo hacia el parser original: stack de nombres de simbolos
+// y la tabla de mapas de strings consultada con el nombre de cada token. Sin
+// recuperacion de errores; devuelve si el input es valido.
+static bool legacyParse(const Grammar &grammar, const unordered_map<string, unordered_map<string, int>> &table,
+                        const string &program) {
+    Scanner scanner{string_view(program)};
+    Token tok = scanner.nextToken();
+    vector<string> stack = {grammar.name(END_ID), grammar.name(grammar.startSymbol())};
+    while (!stack.empty()) {
+        string top = stack.back();
+        string tokStr = tok.type == Token::END ? grammar.name(END_ID) : tok.toString();
+        if (top == tokStr) {
+            if (tok.type == Token::END) return true;
+            stack.pop_back();
+            tok = scanner.nextToken();
+            continue;
+        }
+        auto row = table.find(top);
+        if (row == table.end()) return false;   // terminal que no coincide
+        auto cell = row->second.find(tokStr);
+        if (cell == row->second.end() || cell->second < 0) return false;
+        stack.pop_back();
+        const ProdRule &rule = grammar.rules[cell->second];
+        if (rule.rhs[0].type == EPSILON) continue;
+        for (auto it = rule.rhs.rbegin(); it != rule.rhs.rend(); ++it) stack.push_back(it->value);
+    }
+    return false;
+}
+
+// Compara el paso de prediccion con la tabla anterior (mapas anidados de strings)
+// contra la tabla densa: por cada token se consulta la fila de cada no terminal.
+// Despues, el parseo completo (lexing incluido) con cada tabla sobre el mismo input.
+static void benchPredict(BenchReport &report, const string &program) {
+    Grammar grammar(generateGrammarRules());
+    QuietParser parser(nullptr, &grammar);
+    vector<Token::Type> types = scanAll(program);
+
+    vector<string> nonTerms;
+    vector<int> nonTermRows;
+    unordered_map<string, unordered_map<string, int>> legacyTable;
+    for (int nt = grammar.numTerminals; nt < grammar.symbolCount(); nt++) {
+        nonTerms.push_back(grammar.name(nt));
+        nonTermRows.push_back(nt);
+        for (int t = 0; t <= Token::END; t++) {
+            int col = parser.terminalIndex(static_cast<Token::Type>(t));
+            if (col < 0) continue;
+            legacyTable[grammar.name(nt)][Token(static_cast<Token::Type>(t)).toString()] = parser.predict(nt, col);
+        }
+    }
+
+    long long checksum = 0;
+    auto t0 = Clock::now();
+    for (Token::Type type : types) {
+        Token tok(type);
+        for (const string &nt : nonTerms) {
+            auto row = legacyTable[nt].find(tok.toString());
+            checksum += row == legacyTable[nt].end() ? -1 : row->second;
+        }
+    }
+    double legacySecs = secondsSince(t0);
+
+    long long checksumDense = 0;
+    t0 = Clock::now();
+    for (Token::Type type : types) {
+        int col = parser.terminalIndex(type);
+        for (int row : nonTermRows) {
+            checksumDense += col < 0 ? -1 : parser.predict(row, col);
+        }
+    }
+    double denseSecs = secondsSince(t0);
+
+    if (checksum != checksumDense) {
+        cerr << "Las tablas no coinciden" << endl;
+        exit(1);
+    }
+
+    double n = (double) types.size();
+    report.add("predict", "tabla de mapas", n / legacySecs / 1e6, "Mtokens/s");
+    report.add("predict", "tabla densa", n / denseSecs / 1e6, "Mtokens/s");
+
+    unordered_map<string, unordered_map<string, int>> namedTable;
+    for (int nt = grammar.numTerminals; nt < grammar.symbolCount(); nt++) {
+        for (int t = 0; t < grammar.numTerminals; t++) namedTable[grammar.name(nt)][grammar.name(t)] = parser.predict(nt, t);
+    }
+    t0 = Clock::now();
+    bool legacyOk = legacyParse(grammar, namedTable, program);
+    double legacyParseSecs = secondsSince(t0);
+
+    Scanner scanner{string_view(program)};
+    parser.setScanner(&scanner);
+    t0 = Clock::now();
+    bool denseOk = parser.parse();
+    double denseParseSecs = secondsSince(t0);
+    if (!legacyOk || !denseOk) {
+        cerr << "El parseo completo del programa valido fallo" << endl;
+        exit(1);
+    }
+    report.add("predict", "parseo completo, tabla de mapas", n / legacyParseSecs / 1e6, "Mtokens/s");
+    report.add("predict", "parseo completo, tabla densa", n / denseParseSecs / 1e6, "Mtokens/s");
+}
+
+// Programa con formato: una sentencia por linea, indentacion e identificadores largos
+static string generateFormattedProgram(size_t statements, unsigned seed) {
+    mt19937 rng(seed);
+    const char *names[] = {"x", "total", "accumulatedValue", "temporaryResult42", "i"};
+    string out;
+    for (size_t i = 0; i < statements; i++) {
+        if (i) out += ";\n";
+        out += string(4 * (rng() % 5), ' ');
+        string lhs = names[rng() % 5];
+        string a = names[rng() % 5];
+        out += lhs + " = " + a + " * (" + to_string(rng() % 100000) + " + " + lhs + ")   - 7";
+    }
+    return out;
+}
+
+// Cada kernel sobre el programa generado y sobre uno con mucho espacio en blanco
+static void benchLexing(BenchReport &report, const string &program, size_t tokens) {
+    string formatted = generateFormattedProgram(tokens / 12, 7);
+
+    vector<LexKernels> kernels = {scalarLexKernels()};
+#if defined(__x86_64__)
+    kernels.push_back(sse2LexKernels());
+    if (__builtin_cpu_supports("avx2")) kernels.push_back(avx2LexKernels());
+#endif
+
+    for (const LexKernels &k : kernels) {
+        for (const string *input : {&program, (const string *) &formatted}) {
+            Scanner scanner{string_view(*input)};
+            scanner.useKernels(k);
+            auto t0 = Clock::now();
+            while (scanner.nextToken().type != Token::END) {}
+            double secs = secondsSince(t0);
+            string name = string(k.name) + (input == &program ? "" : " (formateado)");
+            report.add("scanner", name, input->size() / secs / 1e6, "MB/s");
+        }
+    }
+}
+
+// Parseo completo sin traza, con el registro binario de eventos y armando el
+// arbol; ademas un programa con errores, que ejercita la recuperacion
+static void benchParse(BenchReport &report, const string &program, const string &invalid) {
+    auto language = CompiledGrammar::compile(staticGrammar());
+    double n = (double) scanAll(program).size();
+
+    Scanner scanner{string_view(program)};
+    QuietParser quiet(&scanner, language);
+    auto t0 = Clock::now();
+    quiet.parse();
+    double quietSecs = secondsSince(t0);
+
+    Scanner scanner2{string_view(program)};
+    BasicParser<EventLogTrace> logged(&scanner2, language);
+    t0 = Clock::now();
+    logged.parse();
+    double loggedSecs = secondsSince(t0);
+
+    // Dos corridas sobre el mismo arbol: la segunda reusa los bloques de la arena
+    ParseTree tree;
+    double treeSecs = 0;
+    for (int run = 0; run < 2; run++) {
+        Scanner scanner3{string_view(program)};
+        QuietParser builder(&scanner3, language);
+        t0 = Clock::now();
+        builder.parse(&tree);
+        treeSecs = secondsSince(t0);
+    }
+
+    double bad = (double) scanAll(invalid).size();
+    Scanner scanner4{string_view(invalid)};
+    QuietParser recovering(&scanner4, language);
+    t0 = Clock::now();
+    recovering.parse();
+    double invalidSecs = secondsSince(t0);
+
+    report.add("parse", "tokens", n, "tokens");
+    report.add("parse", "QuietTrace", n / quietSecs / 1e6, "Mtokens/s");
+    report.add("parse", "EventLogTrace", n / loggedSecs / 1e6, "Mtokens/s");
+    report.add("parse", "QuietTrace + ParseTree", n / treeSecs / 1e6, "Mtokens/s");
+    report.add("parse", "nodos del arbol", (double) tree.size(), "nodos");
+    report.add("parse", "con errores", bad / invalidSecs / 1e6, "Mtokens/s");
+    report.add("parse", "diagnosticos", (double) recovering.lastResult().diagnostics.size(), "errores");
+}
+
+// Costo de los contadores y reparto del tiempo entre scanner y parser
+static void benchProfile(BenchReport &report, const string &program) {
+    auto language = CompiledGrammar::compile(staticGrammar());
+    double n = (double) scanAll(program).size();
+
+    Scanner scanner{string_view(program)};
+    ProfilingParser parser(&scanner, language);
+    auto t0 = Clock::now();
+    parser.parse();
+    double secs = secondsSince(t0);
+
+    const ParseProfile &profile = parser.tracer().profile;
+    vector<int> hot = profile.hotRules();
+    report.add("perfil", "ProfileTrace", n / secs / 1e6, "Mtokens/s");
+    report.add("perfil", "lexing", 100.0 * profile.scan.nanos / profile.totalNanos, "%");
+    report.add("perfil", "stack maximo", (double) profile.maxStackDepth, "simbolos");
+    if (!hot.empty()) {
+        report.add("perfil", "regla mas aplicada", 100.0 * profile.ruleApplications[hot[0]] / n, "% de los tokens");
+    }
+}
+
+static long peakRssKb() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;   // en KB en Linux
+}
+
+// RSS actual (no el maximo del proceso), de /proc/self/statm; 0 si no se puede leer
+static long currentRssKb() {
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (!statm) return 0;
+    long pages = 0, resident = 0;
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(statm);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Muchos parseos cortos: un parser nuevo por input contra un parser del pool
+// apuntado a cada input con Scanner::reset
+static void benchReuse(BenchReport &report) {
+    auto language = CompiledGrammar::compile(staticGrammar());
+    const char *inputs[] = {"x=5; print(x)", "y=(x+1)*(x-2); print(y)", "z=; print(z"};
+    const int runs = 300000;
+    size_t failures = 0;
+
+    auto t0 = Clock::now();
+    for (int i = 0; i < runs; i++) {
+        Scanner scanner(inputs[i % 3]);
+        QuietParser parser(&scanner, language);
+        failures += !parser.parse();
+    }
+    double freshSecs = secondsSince(t0);
+
+    failures = 0;
+    ParserPool pool(language);
+    Scanner scanner("");
+    long rssBefore = currentRssKb();
+    t0 = Clock::now();
+    for (int i = 0; i < runs; i++) {
+        scanner.reset(inputs[i % 3]);
+        ParserPool::Lease parser = pool.acquire(&scanner);
+        failures += !parser->parse();
+    }
+    double pooledSecs = secondsSince(t0);
+
+    report.add("reuso", "parser nuevo por input", freshSecs / runs * 1e9, "ns/parseo");
+    report.add("reuso", "parser del pool", pooledSecs / runs * 1e9, "ns/parseo");
+    // El maximo del proceso ya lo fijaron los benchmarks anteriores: se mide el RSS actual
+    report.add("reuso", "crecimiento de RSS", (double) (currentRssKb() - rssBefore), "KB");
+    report.add("reuso", "parseos con errores", (double) failures, "parseos");
+}
+
+// Compilacion durante el parseo y ejecucion en la VM
+static void benchVM(BenchReport &report, const string &program) {
+    auto language = CompiledGrammar::compile(generateGrammarRules());
+
+    Bytecode bytecode;
+    auto t0 = Clock::now();
+    if (!compileProgram(language, program, bytecode)) {
+        cerr << "Error al compilar el programa generado" << endl;
+        exit(1);
+    }
+    double compileSecs = secondsSince(t0);
+
+    VM vm;
+    uint64_t ops = 0;
+    t0 = Clock::now();
+    for (int run = 0; run < 20; run++) {
+        vm.output.clear();
+        ops += vm.run(bytecode);
+    }
+    double runSecs = secondsSince(t0);
+
+    report.add("vm", "instrucciones", (double) bytecode.code.size(), "instrucciones");
+    report.add("vm", "slots", (double) bytecode.slotNames.size(), "slots");
+    report.add("vm", "compilacion", program.size() / compileSecs / 1e6, "MB/s");
+    report.add("vm", "ejecucion", ops / runSecs / 1e6, "Mops/s");
+}
+
+// Parseo secuencial contra parseo en paralelo por bloques de sentencias
+static void benchParallel(BenchReport &report, const string &program) {
+    auto language = CompiledGrammar::compile(generateGrammarRules());
+    double mb = program.size() / 1e6;
+
+    Scanner scanner{string_view(program)};
+    QuietParser sequential(&scanner, language);
+    auto t0 = Clock::now();
+    sequential.parse();
+    double seqSecs = secondsSince(t0);
+
+    size_t threads = max(1u, thread::hardware_concurrency());
+    ParallelParser parallel(language, "SL", ';', threads);
+    t0 = Clock::now();
+    ParallelParseResult result = parallel.parse(program);
+    double parSecs = secondsSince(t0);
+
+    report.add("parallel", "hilos", (double) threads, "hilos");
+    report.add("parallel", "bloques", (double) result.chunks, "bloques");
+    report.add("parallel", "secuencial", mb / seqSecs, "MB/s");
+    report.add("parallel", "paralelo", mb / parSecs, "MB/s");
+}
+
+// Parser generado por codegen.cpp contra el parser de tabla, ambos sin traza
+static void benchGenerated(BenchReport &report, const string &program) {
+    Grammar grammar(generateGrammarRules());
+    double n = (double) scanAll(program).size();
+
+    Scanner scanner{string_view(program)};
+    QuietParser table(&scanner, &grammar);
+    auto t0 = Clock::now();
+    bool tableOk = table.parse();
+    double tableSecs = secondsSince(t0);
+
+    Scanner scanner2{string_view(program)};
+    GeneratedParser generated(&scanner2);
+    t0 = Clock::now();
+    bool generatedOk = generated.parse();
+    double generatedSecs = secondsSince(t0);
+
+    if (tableOk != generatedOk) {
+        cerr << "El parser generado y el de tabla no coinciden" << endl;
+        exit(1);
+    }
+    if (grammar.fingerprint() != GeneratedParser::GRAMMAR_FINGERPRINT) {
+        cerr << "generated_parser.hpp esta desactualizado respecto de la gramatica" << endl;
+    }
+    report.add("generado", "tabla (QuietTrace)", n / tableSecs / 1e6, "Mtokens/s");
+    report.add("generado", "GeneratedParser", n / generatedSecs / 1e6, "Mtokens/s");
+}
+
+// Muchos documentos chicos: un parser secuencial reusado contra BatchParser
+static void benchBatch(BenchReport &report, const BenchConfig &cfg) {
+    auto language = CompiledGrammar::compile(staticGrammar());
+    Grammar grammar(generateGrammarRules());
+    ProgramGenerator generator(grammar, cfg.seed);
+    WorkloadOptions options;
+    options.targetTokens = 12;
+    options.maxDepth = 3;
+
+    const size_t docs = 200000;
+    vector<string> texts;
+    for (size_t i = 0; i < docs; i++) texts.push_back(generator.generate(options).text);
+    vector<string_view> inputs(texts.begin(), texts.end());
+
+    Scanner scanner("");
+    QuietParser sequential(&scanner, language);
+    size_t seqOk = 0;
+    auto t0 = Clock::now();
+    for (string_view input : inputs) {
+        scanner.reset(input);
+        seqOk += sequential.parse();
+    }
+    double seqSecs = secondsSince(t0);
+
+    BatchParser batch(language, max(1u, thread::hardware_concurrency()));
+    t0 = Clock::now();
+    vector<ParseResult> results = batch.parse(inputs);
+    double batchSecs = secondsSince(t0);
+
+    size_t batchOk = 0;
+    for (const ParseResult &r : results) batchOk += r.ok;
+    if (batchOk != seqOk) {
+        cerr << "BatchParser y el parser secuencial no coinciden" << endl;
+        exit(1);
+    }
+    report.add("batch", "documentos", (double) docs, "documentos");
+    report.add("batch", "hilos", (double) batch.threads(), "hilos");
+    report.add("batch", "secuencial", docs / seqSecs / 1e6, "Mdocs/s");
+    report.add("batch", "BatchParser", docs / batchSecs / 1e6, "Mdocs/s");
+
+    // Mismo batch con un ProfileTrace por worker, juntados al final
+    ProfileAggregator aggregator;
+    batch.setProfile(&aggregator);
+    t0 = Clock::now();
+    batch.parse(inputs);
+    double profiledSecs = secondsSince(t0);
+    ParseProfile merged = aggregator.snapshot();
+    uint64_t tokens = 0;
+    for (uint64_t n : merged.scan.tokens) tokens += n;
+    if (merged.parses != docs) {
+        cerr << "El perfil de BatchParser no cuenta todos los documentos" << endl;
+        exit(1);
+    }
+    report.add("batch", "BatchParser con perfil", docs / profiledSecs / 1e6, "Mdocs/s");
+    report.add("batch", "tokens (perfil)", (double) tokens, "tokens");
+}
+
+// Ediciones de una tecla sobre un documento grande: reparseo incremental
+// contra volver a parsear todo el buffer
+static void benchIncremental(BenchReport &report, const string &program) {
+    auto language = CompiledGrammar::compile(staticGrammar());
+    Document doc(language, program);
+
+    const int edits = 200;
+    size_t reparsed = 0;
+    auto t0 = Clock::now();
+    for (int i = 0; i < edits; i++) {
+        // Escribe un digito despues de la primera letra de una sentencia y lo borra,
+        // avanzando una sentencia por vez desde el medio del documento
+        size_t at = doc.beginOf((doc.statementCount() / 2 + i) % doc.statementCount()) + 1;
+        reparsed += doc.edit(at, 0, "7");
+        reparsed += doc.edit(at, 1, "");
+    }
+    double incSecs = secondsSince(t0) / (2 * edits);
+
+    // Un ';' que parte una sentencia en dos y se borra: cambia la cantidad de sentencias
+    t0 = Clock::now();
+    for (int i = 0; i < edits; i++) {
+        size_t at = doc.beginOf((doc.statementCount() / 2 + i) % doc.statementCount()) + 1;
+        doc.edit(at, 0, ";");
+        doc.edit(at, 1, "");
+    }
+    double splitSecs = secondsSince(t0) / (2 * edits);
+
+    Scanner scanner{string_view(program)};
+    QuietParser full(&scanner, language);
+    t0 = Clock::now();
+    full.parse();
+    double fullSecs = secondsSince(t0);
+
+    report.add("incremental", "sentencias", (double) doc.statementCount(), "sentencias");
+    report.add("incremental", "reparseadas por edicion", (double) reparsed / (2 * edits), "sentencias");
+    report.add("incremental", "edicion", incSecs * 1e6, "us");
+    report.add("incremental", "edicion con separador", splitSecs * 1e6, "us");
+    report.add("incremental", "parseo completo", fullSecs * 1e6, "us");
+}
+
+// Costo de arranque de la gramatica del lenguaje: construir Grammar (NULLABLE,
+// FIRST, FOLLOW), armar la tabla LL(1), y lo mismo con la gramatica constexpr
+static void benchStartup(BenchReport &report, const string &cacheDir) {
+    const int runs = 20000;
+    volatile int sink = 0;
+    auto t0 = Clock::now();
+    for (int i = 0; i < runs; i++) {
+        Grammar grammar(generateGrammarRules());
+        sink = sink + grammar.numTerminals;
+    }
+    double grammarSecs = secondsSince(t0);
+
+    auto source = make_shared<const Grammar>(generateGrammarRules());
+    t0 = Clock::now();
+    for (int i = 0; i < runs; i++) {
+        auto compiled = CompiledGrammar::compile(source);
+        sink = sink + compiled->predict(source->startSymbol(), 1);
+    }
+    double tableSecs = secondsSince(t0);
+
+    t0 = Clock::now();
+    for (int i = 0; i < runs; i++) {
+        Grammar grammar = staticGrammar();
+        QuietParser parser(nullptr, &grammar);
+        sink = sink + parser.predict(grammar.startSymbol(), 1);
+    }
+    double staticSecs = secondsSince(t0);
+
+    // Parsers que comparten una gramatica compilada: solo se crea el estado propio
+    auto language = CompiledGrammar::compile(staticGrammar());
+    t0 = Clock::now();
+    for (int i = 0; i < runs; i++) {
+        QuietParser parser(nullptr, language);
+        sink = sink + parser.predict(language->grammar().startSymbol(), 1);
+    }
+    double sharedSecs = secondsSince(t0);
+
+    // Cache en disco: la primera llamada compila y escribe, las demas mapean el archivo
+    vector<ProdRule> rules = generateGrammarRules();
+    CompiledGrammar::compileCached(rules, cacheDir);
+    t0 = Clock::now();
+    for (int i = 0; i < runs; i++) {
+        auto cached = CompiledGrammar::compileCached(rules, cacheDir);
+        sink = sink + cached->predict(cached->grammar().startSymbol(), 1);
+    }
+    double cachedSecs = secondsSince(t0);
+
+    report.add("arranque", "Grammar", grammarSecs / runs * 1e6, "us");
+    report.add("arranque", "tabla LL(1)", tableSecs / runs * 1e6, "us");
+    report.add("arranque", "staticGrammar() + parser", staticSecs / runs * 1e6, "us");
+    report.add("arranque", "parser con gramatica compartida", sharedSecs / runs * 1e6, "us");
+    report.add("arranque", "cache en disco", cachedSecs / runs * 1e6, "us");
+}
+
+// Gramatica sintetica con recursion mutua: N_i -> t N_j | N_i+1 t | epsilon
+static vector<ProdRule> generateSyntheticGrammar(int nonTerms, int terms) {
+    vector<ProdRule> rules;
+    auto nt = [](int i) { return Symbol("N" + to_string(i), NON_TERMINAL); };
+    auto t = [](int i) { return Symbol("t" + to_string(i), TERMINAL); };
+    for (int i = 0; i < nonTerms; i++) {
+        string lhs = "N" + to_string(i);
+        rules.emplace_back(lhs, vector<Symbol>{t(i % terms), nt((i * 7 + 1) % nonTerms)});
+        if (i + 1 < nonTerms) rules.emplace_back(lhs, vector<Symbol>{nt(i + 1), t((i + 3) % terms)});
+        rules.emplace_back(lhs, vector<Symbol>{Symbol("epsilon", EPSILON)});
+    }
+    return rules;
+}
+
+// Gramatica sintetica en forma natural, para GrammarTransform: cada N_i tiene
+// recursion directa, un par de alternativas con prefijo comun y, en los impares,
+// recursion indirecta a traves de N_i-1
+static vector<ProdRule> generateNaturalGrammar(int nonTerms, int terms) {
+    vector<ProdRule> rules;
+    auto nt = [](int i) { return Symbol("N" + to_string(i), NON_TERMINAL); };
+    auto t = [](int i) { return Symbol("t" + to_string(i), TERMINAL); };
+    for (int i = 0; i < nonTerms; i++) {
+        string lhs = "N" + to_string(i);
+        int next = (i + 1) % nonTerms;
+        rules.emplace_back(lhs, vector<Symbol>{nt(i), t(i % terms)});
+        rules.emplace_back(lhs, vector<Symbol>{t((i + 1) % terms), nt(next), t((i + 2) % terms)});
+        rules.emplace_back(lhs, vector<Symbol>{t((i + 1) % terms), nt(next), t((i + 3) % terms)});
+        if (i % 2 == 1) rules.emplace_back(lhs, vector<Symbol>{nt(i - 1), t((i + 5) % terms)});
+        else rules.emplace_back(lhs, vector<Symbol>{t((i + 4) % terms)});
+    }
+    return rules;
+}
+
+// Construccion de Grammar con gramaticas naturales de nonTerms y 5x no
+// terminales, que pasan por GrammarTransform, contra la de gramaticas del mismo
+// tamano que ya estan en forma LL(1)
+static void benchTransform(BenchReport &report, int nonTerms) {
+    for (int scale : {1, 5}) {
+        vector<ProdRule> rules = generateNaturalGrammar(nonTerms * scale, 64);
+        auto t0 = Clock::now();
+        Grammar grammar(rules);
+        double secs = secondsSince(t0);
+
+        vector<ProdRule> plain = generateSyntheticGrammar(nonTerms * scale * 4 / 3, 64);
+        t0 = Clock::now();
+        Grammar plainGrammar(plain);
+        double plainSecs = secondsSince(t0);
+
+        string section = "transformacion (" + to_string(rules.size()) + " reglas)";
+        report.add(section, "Grammar con transformacion", secs / rules.size() * 1e9, "ns/regla");
+        report.add(section, "Grammar sin cambios", plainSecs / plain.size() * 1e9, "ns/regla");
+        report.add(section, "reglas resultantes", (double) grammar.rules.size(), "reglas");
+    }
+}
+
+// Gramatica de sentencias que es LL(2): asignacion y llamada empiezan las dos
+// con un ID que llega a traves de no terminales distintos (Target, Callee), y
+// solo el token siguiente (= o '(') decide la regla
+static vector<ProdRule> generateLL2Grammar() {
+    auto nt = [](const char *name) { return Symbol(name, NON_TERMINAL); };
+    auto t = [](const char *name) { return Symbol(name, TERMINAL); };
+    return {
+        {"P", {nt("SL")}},
+        {"SL", {nt("SL"), t(";"), nt("S")}},
+        {"SL", {nt("S")}},
+        {"S", {nt("Target"), t("="), nt("E")}},
+        {"S", {nt("Call")}},
+        {"S", {t("print"), t("("), nt("E"), t(")")}},
+        {"Target", {t("ID")}},
+        {"Call", {nt("Callee"), t("("), nt("E"), t(")")}},
+        {"Callee", {t("ID")}},
+        {"E", {nt("E"), t("+"), nt("T")}},
+        {"E", {nt("T")}},
+        {"T", {t("ID")}},
+        {"T", {t("NUM")}},
+        {"T", {t("("), nt("E"), t(")")}},
+    };
+}
+
+// Decisiones LL(2) contra la tabla LL(1) pura: solo las celdas en conflicto
+// miran el token siguiente
+static void benchLookahead(BenchReport &report, const BenchConfig &cfg, const string &program) {
+    auto t0 = Clock::now();
+    auto language = CompiledGrammar::compile(Grammar(generateLL2Grammar()), 2);
+    double compileSecs = secondsSince(t0);
+
+    ProgramGenerator generator(language->grammar(), cfg.seed);
+    WorkloadOptions options;
+    options.targetTokens = cfg.tokens;
+    options.maxDepth = cfg.depth;
+    string ll2Program = generator.generate(options).text;
+    double n = (double) scanAll(ll2Program).size();
+
+    Scanner scanner{string_view(ll2Program)};
+    QuietParser parser(&scanner, language);
+    t0 = Clock::now();
+    parser.parse();
+    double ll2Secs = secondsSince(t0);
+
+    auto ll1 = CompiledGrammar::compile(staticGrammar());
+    double n1 = (double) scanAll(program).size();
+    Scanner scanner1{string_view(program)};
+    QuietParser parser1(&scanner1, ll1);
+    t0 = Clock::now();
+    parser1.parse();
+    double ll1Secs = secondsSince(t0);
+
+    report.add("lookahead", "compilacion LL(2)", compileSecs * 1e3, "ms");
+    report.add("lookahead", "conflictos sin resolver", (double) language->conflicts().size(), "celdas");
+    report.add("lookahead", "diagnosticos", (double) parser.lastResult().diagnostics.size(), "errores");
+    report.add("lookahead", "gramatica LL(2)", n / ll2Secs / 1e6, "Mtokens/s");
+    report.add("lookahead", "gramatica LL(1)", n1 / ll1Secs / 1e6, "Mtokens/s");
+}
+
+// Construccion de Grammar y de la tabla LL(1) con gramaticas sinteticas de
+// nonTerms, 5x y 15x no terminales (unas 3 reglas por no terminal): el tiempo
+// por regla deberia mantenerse al crecer la gramatica
+static void benchGrammar(BenchReport &report, int nonTerms, const string &cacheDir) {
+    for (int scale : {1, 5, 15}) {
+        vector<ProdRule> rules = generateSyntheticGrammar(nonTerms * scale, 64);
+        auto t0 = Clock::now();
+        auto grammar = make_shared<const Grammar>(rules);
+        double grammarSecs = secondsSince(t0);
+
+        t0 = Clock::now();
+        auto compiled = CompiledGrammar::compile(grammar);
+        double tableSecs = secondsSince(t0);
+
+        // Arranque con la cache en disco: mapear y validar en lugar de construir
+        uint64_t key = CompiledGrammar::cacheKey(rules);
+        string path = cacheDir + "/bench-sintetica.ll1";
+        compiled->save(path, key);
+        t0 = Clock::now();
+        auto cached = CompiledGrammar::load(path, key);
+        double cacheSecs = secondsSince(t0);
+        unlink(path.c_str());
+
+        string section = "gramatica sintetica (" + to_string(rules.size()) + " reglas)";
+        report.add(section, "Grammar", grammarSecs * 1e3, "ms");
+        report.add(section, "tabla LL(1)", tableSecs * 1e3, "ms");
+        report.add(section, "tabla LL(1) por regla", tableSecs / rules.size() * 1e9, "ns");
+        report.add(section, "conflictos", (double) compiled->conflicts().size(), "celdas");
+        report.add(section, "cache en disco", cached ? cacheSecs * 1e3 : -1, "ms");
+    }
+}
+
+static bool parseArgs(int argc, char **argv, BenchConfig &cfg) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--json") cfg.json = true;
+        else if (arg == "--tokens" && hasValue) cfg.tokens = stoul(argv[++i]);
+        else if (arg == "--depth" && hasValue) cfg.depth = stoi(argv[++i]);
+        else if (arg == "--errors" && hasValue) cfg.errorRate = stod(argv[++i]);
+        else if (arg == "--seed" && hasValue) cfg.seed = (unsigned) stoul(argv[++i]);
+        else if (arg == "--nonterms" && hasValue) cfg.nonTerms = stoi(argv[++i]);
+        else if (arg == "--cache-dir" && hasValue) cfg.cacheDir = argv[++i];
+        else return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    BenchConfig cfg;
+    if (!parseArgs(argc, argv, cfg)) {
+        cerr << "Uso: " << argv[0] << " [--json] [--tokens N] [--depth N] [--errors P] [--seed N] [--nonterms N]"
+             << " [--cache-dir DIR]"
+             << endl;
+        return 1;
+    }
+
+    BenchReport report;
+    auto t0 = Clock::now();
+    GeneratedProgram valid = generateWorkload(cfg, cfg.seed, 0);
+    GeneratedProgram invalid = generateWorkload(cfg, cfg.seed + 1, cfg.errorRate);
+    report.add("workload", "programa valido", valid.text.size() / 1e6, "MB");
+    report.add("workload", "programa con errores", invalid.text.size() / 1e6, "MB");
+    report.add("workload", "mutaciones", (double) invalid.mutations, "tokens");
+    report.add("workload", "generacion", secondsSince(t0) * 1e3, "ms");
+
+    benchStartup(report, cfg.cacheDir);
+    benchPredict(report, valid.text);
+    benchLexing(report, valid.text, cfg.tokens);
+    benchParse(report, valid.text, invalid.text);
+    benchProfile(report, valid.text);
+    benchGenerated(report, valid.text);
+    benchVM(report, valid.text);
+    benchParallel(report, valid.text);
+    benchBatch(report, cfg);
+    benchIncremental(report, valid.text);
+    benchGrammar(report, cfg.nonTerms, cfg.cacheDir);
+    benchTransform(report, cfg.nonTerms);
+    benchLookahead(report, cfg, valid.text);
+
+    benchReuse(report);
+
+    report.add("proceso", "RSS maximo", peakRssKb() / 1024.0, "MB");
+
+    if (cfg.json) report.printJson(cout, cfg, Grammar(generateGrammarRules()).fingerprint());
+    else report.printText(cout);
+    return 0;
+}
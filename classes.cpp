@@ -1,16 +1,33 @@
+#pragma once
+
 #include <string>
+#include <array>
 #include <vector>
+#include <cstring>
+#include <cstdint>
 #include <iostream>
 #include <map>
+#include <set>
+#include <cstdio>
 #include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
-#include <stack>
+#include <string_view>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
-static unordered_set<string> TERMINALS = {"ID", "NUM", "=", ";", "(", ")", "+", "-", "*", "print", "$"};
-
 enum Type {
     DOLAR,
     TERMINAL, 
@@ -19,580 +36,2896 @@ enum Type {
    
 };
 
+// IDs reservados: el fin de input ($) es siempre el terminal 0, epsilon no es un simbolo
+const int END_ID = 0;
+const int EPSILON_ID = -1;
+// En el stack del parser, REDUCE_MARKER - r marca el fin de la regla r
+const int REDUCE_MARKER = -2;
+
 struct Symbol {
-    string value;
+    string value;   // nombre, solo para diagnosticos
     Type type;
+    int id;         // asignado por la gramatica al internar
 
     Symbol(string v, Type t){
         value = v;
         type = t;
+        id = t == EPSILON ? EPSILON_ID : (t == DOLAR ? END_ID : -1);
     }
 
     bool operator==(const Symbol &rhs) const {
-        // return value == rhs.value && type == rhs.type;
-        bool typematch = type == rhs.type;
-        bool valuematch = value == rhs.value;
-        return typematch && valuematch;
+        return id == rhs.id && type == rhs.type;
     }
 };
 
-struct HashSym {
-    size_t operator()(const Symbol &symbol) const {
-        size_t ret = hash<string>()(symbol.value) ^ std::hash<int>()(static_cast<int>(symbol.type));
-        return ret; 
+// Conjunto de terminales como bitset indexado por ID de terminal
+struct TermSet {
+    vector<uint64_t> words;
+
+    TermSet() = default;
+    explicit TermSet(int numTerminals){
+        words.assign((numTerminals + 63) / 64, 0);
     }
-};
 
-struct EqSym {
-    bool operator()(const Symbol &lhs, const Symbol &rhs) const {
-        return lhs.value == rhs.value && lhs.type == rhs.type;
+    void insert(int id){
+        words[id >> 6] |= 1ull << (id & 63);
+    }
+
+    bool contains(int id) const {
+        return (words[id >> 6] >> (id & 63)) & 1;
     }
-};
 
-using SetSym = unordered_set<Symbol, HashSym, EqSym>;
+    // Une otro conjunto a este; devuelve true si cambio
+    bool unionWith(const TermSet &other){
+        uint64_t changed = 0;
+        for (size_t i = 0; i < words.size(); i++) {
+            uint64_t old = words[i];
+            words[i] |= other.words[i];
+            changed |= words[i] ^ old;
+        }
+        return changed != 0;
+    }
+
+    template <class F>
+    void forEach(F f) const {
+        for (size_t i = 0; i < words.size(); i++) {
+            for (uint64_t w = words[i]; w; w &= w - 1) {
+                f((int) (i * 64 + __builtin_ctzll(w)));
+            }
+        }
+    }
+};
 
 struct ProdRule {
-    string lhs;
+    string lhs;     // nombre, solo para diagnosticos
+    int lhsId;
     vector<Symbol> rhs;
 
     ProdRule(string l, vector<Symbol> r){
         lhs = l;
+        lhsId = -1;
         rhs = r;
     }
 
     bool operator==(const ProdRule &_rhs) const {
         bool eq = false;
-        if (lhs == _rhs.lhs && rhs == _rhs.rhs){
+        if (lhsId == _rhs.lhsId && rhs == _rhs.rhs){
             eq = true;
         }
         return eq;
     }
 };
 
-class Grammar {
-    public:
-        vector<ProdRule> rules;
-        unordered_set<string> terminals;
-        unordered_set<string> nonTerminals;
-        unordered_map<string, SetSym> FIRST;
-        unordered_map<string, SetSym> FOLLOW;
+// Gramatica declarada como dato constexpr. Los simbolos son IDs: los terminales
+// ocupan [0, T) con $ en 0 y los no terminales [T, T+N) con el inicial primero,
+// igual que en Grammar. Una RHS de largo 0 es epsilon.
+const int STATIC_MAX_RHS = 4;
 
-        Grammar() = default;
-        Grammar(vector<ProdRule> r){
-            rules = r;
-            for (auto &rule: rules) {
-                this->nonTerminals.insert(rule.lhs);
-                for (const auto &symbol: rule.rhs) {
-                    if (symbol.type == NON_TERMINAL){
-                        this->nonTerminals.insert(symbol.value);
-                        }
-                    else if (symbol.type == TERMINAL) {
-                        this->terminals.insert(symbol.value);
-                        }
-                }
-            }
-            terminals.insert("epsilon");
+// Celda de la tabla LL(1): indice de regla, -1 (error) o -2 (sincronizacion).
+// 32 bits para admitir gramaticas generadas con mas de 32767 reglas.
+using ParseCell = int32_t;
 
-            calcFirst();
-            calcFollow();
+struct StaticRule {
+    int lhs;
+    int length;
+    int rhs[STATIC_MAX_RHS];
+};
+
+template <int T, int N, int R>
+struct StaticGrammar {
+    static_assert(T <= 64, "StaticGrammar admite hasta 64 terminales");
+
+    static constexpr int NUM_TERMINALS = T;
+    static constexpr int NUM_SYMBOLS = T + N;
+    static constexpr int NUM_RULES = R;
+
+    array<const char *, T + N> names;
+    array<StaticRule, R> rules;
+};
+
+// NULLABLE/FIRST/FOLLOW y tabla LL(1) calculados en tiempo de compilacion.
+// Los conjuntos son mascaras de bits de terminales; la tabla usa las mismas
+// celdas que BasicParser: indice de regla, -1 (error) o -2 (sincronizacion).
+template <int T, int N, int R>
+struct StaticTables {
+    array<bool, T + N> nullable{};
+    array<uint64_t, T + N> first{};
+    array<uint64_t, T + N> follow{};
+    array<ParseCell, N * T> table{};
+    // Primera celda con dos reglas, o -1 si la gramatica es LL(1)
+    int conflictNonTerm = -1;
+    int conflictTerm = -1;
+};
+
+template <int T, int N, int R>
+constexpr StaticTables<T, N, R> computeStaticTables(const StaticGrammar<T, N, R> &g) {
+    StaticTables<T, N, R> out;
+    for (int t = 0; t < T; t++) out.first[t] = 1ull << t;
+
+    // Puntos fijos simples: en tiempo de compilacion no hace falta lista de trabajo
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const StaticRule &rule : g.rules) {
+            bool nullable = true;
+            uint64_t first = 0;
+            for (int i = 0; i < rule.length && nullable; i++) {
+                first |= out.first[rule.rhs[i]];
+                nullable = out.nullable[rule.rhs[i]];
+            }
+            uint64_t merged = out.first[rule.lhs] | first;
+            if (merged != out.first[rule.lhs] || (nullable && !out.nullable[rule.lhs])) changed = true;
+            out.first[rule.lhs] = merged;
+            out.nullable[rule.lhs] = out.nullable[rule.lhs] || nullable;
         }
+    }
 
-        static bool isTerminal(const string &symbol){
-                return TERMINALS.find(symbol) != TERMINALS.end();
+    out.follow[T] = 1ull << END_ID;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const StaticRule &rule : g.rules) {
+            uint64_t suffix = out.follow[rule.lhs];
+            for (int i = rule.length - 1; i >= 0; i--) {
+                int symbol = rule.rhs[i];
+                if (symbol >= T) {
+                    uint64_t merged = out.follow[symbol] | suffix;
+                    if (merged != out.follow[symbol]) changed = true;
+                    out.follow[symbol] = merged;
+                }
+                suffix = out.nullable[symbol] ? suffix | out.first[symbol] : out.first[symbol];
             }
+        }
+    }
 
-        const vector<ProdRule> &grammarRules(){
-            return rules;
+    for (int i = 0; i < N * T; i++) out.table[i] = -1;
+    for (int r = 0; r < R; r++) {
+        const StaticRule &rule = g.rules[r];
+        uint64_t predict = 0;
+        bool nullable = true;
+        for (int i = 0; i < rule.length && nullable; i++) {
+            predict |= out.first[rule.rhs[i]];
+            nullable = out.nullable[rule.rhs[i]];
+        }
+        if (nullable) predict |= out.follow[rule.lhs];
+        for (int t = 0; t < T; t++) {
+            if (!((predict >> t) & 1)) continue;
+            ParseCell &cell = out.table[(rule.lhs - T) * T + t];
+            if (cell != -1 && out.conflictNonTerm < 0) {
+                out.conflictNonTerm = rule.lhs;
+                out.conflictTerm = t;
+            }
+            cell = r;
+        }
+    }
+    for (int nonTerm = T; nonTerm < T + N; nonTerm++) {
+        for (int t = 0; t < T; t++) {
+            ParseCell &cell = out.table[(nonTerm - T) * T + t];
+            if (cell == -1 && ((out.follow[nonTerm] >> t) & 1)) cell = -2;
+        }
+    }
+    return out;
+}
+
+// Lleva una gramatica escrita en forma natural a una apta para LL(1): elimina la
+// recursion por izquierda (E -> E + T | T pasa a E -> T E', E' -> + T E' | epsilon)
+// y factoriza prefijos comunes (S -> a b | a c pasa a S -> a S', S' -> b | c).
+// Solo los no terminales en ciclos del grafo de esquinas izquierdas pasan por la
+// sustitucion de Paull; el resto se recorre una vez, asi el costo es casi lineal
+// en el tamano de la gramatica. No se ven las esquinas detras de prefijos
+// nullables ni los prefijos comunes que aparecen recien al expandir otro no
+// terminal: esos casos siguen apareciendo como conflictos de la tabla.
+class GrammarTransform {
+    private:
+        // Los simbolos se trabajan con los IDs que les dio la gramatica: >= 0 es un
+        // no terminal (ID - numTerminals, indice en nonTerms) y < 0 es el terminal
+        // leaves[-code - 1]
+        struct NonTerm {
+            string name;
+            vector<vector<int>> alts;   // una RHS vacia es epsilon
+            vector<int> derived;        // no terminales nuevos creados a partir de este
+        };
+
+        vector<NonTerm> nonTerms;
+        vector<Symbol> leaves;
+        unordered_set<string> usedNames;    // se arma con el primer no terminal nuevo
+        bool changed = false;
+
+        // No terminal con que empieza la alternativa, o -1
+        static int leftCorner(const vector<int> &alt) {
+            return alt.empty() || alt[0] < 0 ? -1 : alt[0];
         }
 
-        SetSym calcFirst(const vector<Symbol> &rhs){
-            SetSym firstSet;
-            bool canContainEpsilon = true;
+        // Nuevo no terminal con el nombre del padre y comillas: E', E'', ...
+        int addNonTerm(int parent) {
+            if (usedNames.empty()) {
+                for (const NonTerm &nonTerm : nonTerms) usedNames.insert(nonTerm.name);
+                for (const Symbol &leaf : leaves) usedNames.insert(leaf.value);
+            }
+            string name = nonTerms[parent].name + "'";
+            while (usedNames.count(name)) name += "'";
+            usedNames.insert(name);
+            int id = (int) nonTerms.size();
+            nonTerms.push_back({name, {}, {}});
+            nonTerms[parent].derived.push_back(id);
+            changed = true;
+            return id;
+        }
 
-            for (const auto &symbol: rhs) {
-                if (symbol.type == TERMINAL) {
-                    firstSet.insert(symbol);
-                    canContainEpsilon = false;
-                    break;
+        // A -> A a | b  pasa a  A -> b A', A' -> a A' | epsilon. Si todas las
+        // alternativas son recursivas A no deriva ninguna cadena y se deja como
+        // esta: sin reglas desapareceria de la gramatica (y con el simbolo
+        // inicial cambiaria el lenguaje); Grammar::productive lo detecta
+        void eliminateDirect(int a) {
+            bool recursive = false, base = false;
+            for (const vector<int> &alt : nonTerms[a].alts) {
+                if (leftCorner(alt) == a) recursive = true;
+                else base = true;
+            }
+            if (!recursive || !base) return;
+
+            vector<vector<int>> alts = std::move(nonTerms[a].alts);
+            nonTerms[a].alts.clear();
+            int tail = addNonTerm(a);
+            for (vector<int> &alt : alts) {
+                if (leftCorner(alt) != a) {
+                    alt.push_back(tail);
+                    nonTerms[a].alts.push_back(std::move(alt));
+                } else if (alt.size() > 1) {   // A -> A no agrega nada al lenguaje
+                    vector<int> rhs(alt.begin() + 1, alt.end());
+                    rhs.push_back(tail);
+                    nonTerms[tail].alts.push_back(std::move(rhs));
                 }
+            }
+            nonTerms[tail].alts.emplace_back();
+        }
 
-                if (symbol.type == EPSILON) {
-                    firstSet.insert(symbol);
-                    break;
+        // Reemplaza las alternativas A -> B g por A -> d g para cada B -> d
+        void substitute(int a, int b) {
+            vector<vector<int>> alts;
+            for (vector<int> &alt : nonTerms[a].alts) {
+                if (leftCorner(alt) != b) {
+                    alts.push_back(std::move(alt));
+                    continue;
                 }
+                for (const vector<int> &delta : nonTerms[b].alts) {
+                    vector<int> rhs = delta;
+                    rhs.insert(rhs.end(), alt.begin() + 1, alt.end());
+                    alts.push_back(std::move(rhs));
+                }
+                changed = true;
+            }
+            nonTerms[a].alts = std::move(alts);
+        }
 
-                if (FIRST.find(symbol.value) == FIRST.end()) {
-                    for (const ProdRule &rule: grammarRule(symbol.value)) {
-                        SetSym firstY = calcFirst(rule.rhs);
-                        FIRST[symbol.value].insert(firstY.begin(), firstY.end());
+        // Componentes fuertemente conexas (Tarjan sin recursion) del grafo A -> B
+        // por cada alternativa A -> B ...; comp[a] es la componente de a
+        int leftCornerCycles(vector<int> &comp) const {
+            int n = (int) nonTerms.size();
+            vector<int> num(n, -1), low(n, 0), open;
+            vector<char> onStack(n, false);
+            comp.assign(n, -1);
+            int counter = 0, comps = 0;
+            for (int root = 0; root < n; root++) {
+                if (num[root] >= 0) continue;
+                // Por cada nodo abierto: el nodo y la proxima alternativa a visitar
+                vector<pair<int, size_t>> calls = {{root, 0}};
+                num[root] = low[root] = counter++;
+                open.push_back(root);
+                onStack[root] = true;
+                while (!calls.empty()) {
+                    int v = calls.back().first;
+                    size_t &next = calls.back().second;
+                    if (next < nonTerms[v].alts.size()) {
+                        int w = leftCorner(nonTerms[v].alts[next++]);
+                        if (w < 0) continue;
+                        if (num[w] < 0) {
+                            num[w] = low[w] = counter++;
+                            open.push_back(w);
+                            onStack[w] = true;
+                            calls.push_back({w, 0});
+                        } else if (onStack[w]) {
+                            low[v] = min(low[v], num[w]);
+                        }
+                        continue;
                     }
+                    if (low[v] == num[v]) {
+                        int w;
+                        do {
+                            w = open.back();
+                            open.pop_back();
+                            onStack[w] = false;
+                            comp[w] = comps;
+                        } while (w != v);
+                        comps++;
+                    }
+                    calls.pop_back();
+                    if (!calls.empty()) low[calls.back().first] = min(low[calls.back().first], low[v]);
                 }
+            }
+            return comps;
+        }
 
-                const SetSym &firstY = FIRST[symbol.value];
-                bool hasEpsilon = false;
-                for (const Symbol &sym: firstY) {
-                    if (sym.type != EPSILON) firstSet.insert(sym);
-                    else hasEpsilon = true;
+        void eliminateLeftRecursion() {
+            int n = (int) nonTerms.size();
+            vector<int> comp;
+            vector<vector<int>> cycles(leftCornerCycles(comp));
+            for (int a = 0; a < n; a++) cycles[comp[a]].push_back(a);
+
+            // Entradas a cada ciclo: el inicial y los usados desde fuera del ciclo
+            vector<char> entry(n, false);
+            entry[0] = true;
+            for (int a = 0; a < n; a++) {
+                for (const vector<int> &alt : nonTerms[a].alts) {
+                    for (int symbol : alt) {
+                        if (symbol >= 0 && comp[symbol] != comp[a]) entry[symbol] = true;
+                    }
                 }
+            }
 
-                if (!hasEpsilon) {
-                    canContainEpsilon = false;
-                    break;
+            for (vector<int> &cycle : cycles) {
+                if (cycle.size() == 1) {
+                    eliminateDirect(cycle[0]);
+                    continue;
+                }
+                // Las entradas van al final: absorben la recursion del ciclo como
+                // recursion directa y quedan con la forma X -> a X', X' -> b X' | epsilon
+                stable_partition(cycle.begin(), cycle.end(), [&](int a) { return !entry[a]; });
+                // Paull restringido al ciclo: se sustituyen las esquinas hacia
+                // miembros anteriores y queda solo recursion directa
+                for (size_t i = 0; i < cycle.size(); i++) {
+                    for (size_t j = 0; j < i; j++) substitute(cycle[i], cycle[j]);
+                    eliminateDirect(cycle[i]);
+                }
+                // Ahora cada miembro solo empieza con miembros posteriores: se
+                // sustituyen de atras hacia adelante para que ninguno empiece con
+                // otro del ciclo y los prefijos comunes queden a la vista
+                for (size_t i = cycle.size(); i-- > 0;) {
+                    for (size_t j = i + 1; j < cycle.size(); j++) substitute(cycle[i], cycle[j]);
                 }
             }
-
-            if (canContainEpsilon) firstSet.insert({"epsilon", EPSILON});
-            FIRST[rhs[0].value].insert(firstSet.begin(), firstSet.end());
-            return firstSet;
         }
 
-        SetSym calcFollow(const string &lhs){
-            SetSym follow;
-            if (FOLLOW.find(lhs) != FOLLOW.end()){
-                return FOLLOW[lhs];
-            }
-            if (lhs == rules[0].lhs){
-                follow.insert({"$", DOLAR});
+        // No terminales alcanzables desde el inicial
+        vector<char> reachable() const {
+            vector<char> seen(nonTerms.size(), false);
+            vector<int> pending = {0};
+            seen[0] = true;
+            while (!pending.empty()) {
+                int a = pending.back();
+                pending.pop_back();
+                for (const vector<int> &alt : nonTerms[a].alts) {
+                    for (int symbol : alt) {
+                        if (symbol >= 0 && !seen[symbol]) {
+                            seen[symbol] = true;
+                            pending.push_back(symbol);
+                        }
+                    }
                 }
+            }
+            return seen;
+        }
 
-            for (const auto &rule: rules) {
-                if (rule.lhs == lhs) continue;
-
-                for (int i = 0; i < rule.rhs.size(); i++) {
-                    const vector<Symbol> &thisrhs = rule.rhs;
-
-                    if (thisrhs[i].value == lhs) {
-                        const string &currentLHS = rule.lhs;
-
-                        if (i == thisrhs.size() - 1) {
-                            SetSym followY = calcFollow(currentLHS);
-                            follow.insert(followY.begin(), followY.end());
-                        } else {
-                            vector<Symbol> gamma(
-                                    thisrhs.begin() + i + 1,
-                                    rule.rhs.end());
-
-                            SetSym firstGamma = calcFirst(gamma);
-                            bool hasEpsilon = false;
-
-                            for (const Symbol &symbol: firstGamma) {
-                                if (symbol.type != EPSILON) follow.insert(symbol);
-                                else hasEpsilon = true;
-                            }
-
-                            if (hasEpsilon) {
-                                SetSym followY = calcFollow(currentLHS);
-                                follow.insert(followY.begin(), followY.end());
-                            }
+        // Agrupa las alternativas por primer simbolo y saca el prefijo comun de
+        // cada grupo a un no terminal nuevo, que a su vez se factoriza despues
+        void leftFactor(int a) {
+            const vector<vector<int>> &current = nonTerms[a].alts;
+            if (current.size() < 2) return;
+            // Caso comun: pocas alternativas que empiezan todas distinto
+            if (current.size() <= 16) {
+                bool shared = false;
+                for (size_t i = 0; i < current.size() && !shared; i++) {
+                    for (size_t j = 0; j < i && !shared; j++) {
+                        shared = !current[i].empty() && !current[j].empty() && current[i][0] == current[j][0];
+                    }
+                }
+                if (!shared) return;
+            }
+            vector<vector<int>> alts = std::move(nonTerms[a].alts);
+            nonTerms[a].alts.clear();
+            // Las RHS vacias quedan cada una en su grupo
+            vector<int> keys;
+            vector<vector<size_t>> groups;
+            unordered_map<int, size_t> groupOf;
+            for (size_t i = 0; i < alts.size(); i++) {
+                size_t g = groups.size();
+                int key = alts[i].empty() ? 0 : alts[i][0];
+                if (!alts[i].empty()) {
+                    // Con pocas alternativas alcanza una busqueda lineal
+                    if (alts.size() <= 16) {
+                        for (size_t k = 0; k < keys.size(); k++) {
+                            if (keys[k] == key && !alts[groups[k][0]].empty()) g = k;
                         }
+                    } else {
+                        g = groupOf.emplace(key, groups.size()).first->second;
                     }
                 }
+                if (g == groups.size()) {
+                    keys.push_back(key);
+                    groups.emplace_back();
+                }
+                groups[g].push_back(i);
             }
 
-            FOLLOW[lhs] = follow;
-            return follow;
-            
+            for (const vector<size_t> &group : groups) {
+                const vector<int> &first = alts[group[0]];
+                size_t prefix = first.size();
+                for (size_t g = 1; g < group.size(); g++) {
+                    const vector<int> &alt = alts[group[g]];
+                    size_t k = 0;
+                    while (k < prefix && k < alt.size() && alt[k] == first[k]) k++;
+                    prefix = k;
+                }
+                if (group.size() == 1 || prefix == 0) {
+                    for (size_t i : group) nonTerms[a].alts.push_back(std::move(alts[i]));
+                    continue;
+                }
+                int tail = addNonTerm(a);
+                vector<int> factored(first.begin(), first.begin() + prefix);
+                factored.push_back(tail);
+                nonTerms[a].alts.push_back(std::move(factored));
+                for (size_t i : group) nonTerms[tail].alts.emplace_back(alts[i].begin() + prefix, alts[i].end());
+            }
         }
 
-        //calculamos el first recursivamente
-        void calcFirst(){
-            for (const auto &rule: rules) {
-                SetSym firstTemp = calcFirst(rule.rhs);
-                FIRST[rule.lhs].insert(firstTemp.begin(), firstTemp.end());
-            }
+        Symbol symbolFor(int code) const {
+            return code >= 0 ? Symbol(nonTerms[code].name, NON_TERMINAL) : leaves[-code - 1];
         }
 
-        //calculamos el follow recursivamente
-        void calcFollow(){
-            for (const auto &rule: rules){
-                calcFollow(rule.lhs);
+    public:
+        // rules con los IDs ya resueltos (Grammar::internSymbols); names es la tabla
+        // de simbolos, con los terminales en [0, numTerminals)
+        GrammarTransform(const vector<ProdRule> &rules, const vector<string> &names, int numTerminals) {
+            leaves.assign(numTerminals, Symbol("", TERMINAL));
+            for (int id = numTerminals; id < (int) names.size(); id++) nonTerms.push_back({names[id], {}, {}});
+            for (const ProdRule &rule : rules) {
+                vector<int> alt;
+                alt.reserve(rule.rhs.size());
+                for (const Symbol &symbol : rule.rhs) {
+                    if (symbol.type == EPSILON) continue;
+                    if (symbol.type == NON_TERMINAL) {
+                        alt.push_back(symbol.id - numTerminals);
+                        continue;
+                    }
+                    leaves[symbol.id] = symbol;
+                    alt.push_back(-symbol.id - 1);
+                }
+                nonTerms[rule.lhsId - numTerminals].alts.push_back(std::move(alt));
             }
         }
-        vector<ProdRule> grammarRule(const string &lhs){
-            vector<ProdRule> matchingRules;
-            copy_if(rules.begin(), rules.end(),
-                        back_inserter(matchingRules),
-                        [&lhs](const ProdRule &rule) { 
-                            return rule.lhs == lhs; 
-                            }
-            );
-            return matchingRules;
-        }
 
+        // Reemplaza rules por la gramatica transformada; cada no terminal nuevo
+        // queda despues del que lo origino. Si no hay nada que cambiar devuelve
+        // false y rules queda igual, con el mismo orden e indices de regla.
+        bool apply(vector<ProdRule> &rules) {
+            if (nonTerms.empty()) return false;
+            size_t original = nonTerms.size();
+            vector<char> reachableBefore = reachable();
+            eliminateLeftRecursion();
+            for (size_t a = 0; a < nonTerms.size(); a++) leftFactor((int) a);
+            if (!changed) return false;
+
+            // Se descartan los no terminales que dejaron de ser alcanzables porque
+            // quedaron sustituidos en todos lados: sus reglas muertas agregarian
+            // entradas falsas a FOLLOW. Los que ya eran inalcanzables se conservan.
+            vector<char> reachableAfter = reachable();
+            vector<ProdRule> out;
+            for (size_t root = 0; root < original; root++) {
+                vector<int> pending = {(int) root};
+                while (!pending.empty()) {
+                    int a = pending.back();
+                    pending.pop_back();
+                    pending.insert(pending.end(), nonTerms[a].derived.rbegin(), nonTerms[a].derived.rend());
+                    bool existedBefore = a < (int) original;
+                    if (!reachableAfter[a] && (!existedBefore || reachableBefore[a])) continue;
+                    for (const vector<int> &alt : nonTerms[a].alts) {
+                        vector<Symbol> rhs;
+                        for (int code : alt) rhs.push_back(symbolFor(code));
+                        if (rhs.empty()) rhs.emplace_back("epsilon", EPSILON);
+                        out.emplace_back(nonTerms[a].name, std::move(rhs));
+                    }
+                }
+            }
+            rules = std::move(out);
+            return true;
+        }
 };
 
+class MappedFile;
+
+// Formato binario de la cache en disco de gramaticas compiladas (ver
+// CompiledGrammar::save y load). Despues del encabezado vienen secciones
+// alineadas a 8 bytes, en este orden: offsets de los nombres de simbolo (uint32,
+// S + 1) y sus caracteres; inicio de la RHS de cada regla (uint32, R + 1), LHS
+// (int32, R), IDs y tipos de los simbolos de las RHS (int32 y uint8); NULLABLE
+// (uint8, S); FIRST y FOLLOW (uint64, S * setWords cada uno); la tabla LL(1)
+// (ParseCell, N * T); los nodos de lookahead (ParseCell) y los conflictos (4
+// int32 cada uno). Los enteros van en el orden de bytes de la maquina que lo
+// escribio; byteOrder lo verifica.
+struct GrammarImage {
+    static constexpr uint32_t VERSION = 3;
+    static constexpr uint32_t ENDIAN_MARK = 0x01020304;
+
+    struct Header {
+        char magic[8];
+        uint32_t byteOrder;
+        uint32_t version;
+        uint64_t key;
+        uint64_t fileSize;
+        uint64_t checksum;   // de todo el archivo con este campo en cero, ver checksum()
+        int32_t numTerminals;
+        int32_t numSymbols;
+        int32_t numRules;
+        int32_t rhsLength;
+        int32_t nameBytes;
+        int32_t lookaheadDepth;
+        int32_t lookaheadCells;
+        int32_t numConflicts;
+    };
+
+    Header header;
+    const uint32_t *nameOffsets;
+    const char *names;
+    const uint32_t *rhsStart;
+    const int32_t *lhs;
+    const int32_t *rhsIds;
+    const uint8_t *rhsTypes;
+    const uint8_t *nullable;
+    const uint64_t *first;
+    const uint64_t *follow;
+    const ParseCell *table;
+    const ParseCell *lookahead;
+    const int32_t *conflicts;
+
+    static void magic(char out[8]) {
+        memcpy(out, "LL1CACHE", 8);
+    }
 
-class Token {
-public:
-    enum Type {
-        ID, NUM, ASSIGN, SEMI, LP, RP, PLUS, MIN, MUL, ERR, PRINT, END};
-
-    Type type;
-    string lexeme;
-
-    // Constructor
-    explicit Token(Type t){
-        type = t;
+    static int setWords(int numTerminals) {
+        return (numTerminals + 63) / 64;
     }
 
-    Token(Type t, char l) 
-    { 
-        type = t;
-        lexeme = l; }
+    // FNV-1a por palabras de 8 bytes (las secciones ya estan alineadas a 8) del
+    // encabezado, con checksum en cero, y de las secciones; un archivo truncado o
+    // con bytes cambiados no se carga y se vuelve a escribir
+    static uint64_t checksum(Header h, string_view sections) {
+        h.checksum = 0;
+        uint64_t hash = 14695981039346656037ull;
+        auto add = [&hash](const char *data, size_t bytes) {
+            size_t i = 0;
+            for (; i + 8 <= bytes; i += 8) {
+                uint64_t word;
+                memcpy(&word, data + i, 8);
+                hash = (hash ^ word) * 1099511628211ull;
+            }
+            for (; i < bytes; i++) hash = (hash ^ (unsigned char) data[i]) * 1099511628211ull;
+        };
+        add(reinterpret_cast<const char *>(&h), sizeof(h));
+        add(sections.data(), sections.size());
+        return hash;
+    }
 
-    Token(Type t, string l) {
-        type = t;
-        lexeme = l; 
+    // Valida el encabezado, los tamanos de las secciones y los IDs de simbolo, y
+    // apunta los campos a data. Devuelve false si data no es una imagen de esta
+    // version con la clave key. Las celdas de las tablas las valida CompiledGrammar.
+    bool read(string_view data, uint64_t key) {
+        if (data.size() < sizeof(Header)) return false;
+        memcpy(&header, data.data(), sizeof(Header));
+        char expected[8];
+        magic(expected);
+        if (memcmp(header.magic, expected, 8) != 0 || header.byteOrder != ENDIAN_MARK || header.version != VERSION
+            || header.key != key || header.fileSize != data.size()
+            || header.checksum != checksum(header, data.substr(sizeof(Header)))) {
+            return false;
+        }
+        const Header &h = header;
+        if (h.numTerminals < 1 || h.numSymbols < h.numTerminals || h.numRules < 1 || h.rhsLength < 0
+            || h.nameBytes < 0 || h.lookaheadCells < 0 || h.numConflicts < 0) {
+            return false;
         }
 
-    string toString() const {
-        switch (type) {
-            case ID: return "ID";
-            case NUM: return "NUM";
-            case ASSIGN: return "=";
-            case SEMI: return ";";
-            case LP: return "(";
-            case RP: return ")";
-            case PLUS: return "+";
-            case MIN: return "-";
-            case MUL: return "*";
-            case ERR: return "ERR";
-            case PRINT: return "print";
-            case END: return "epsilon";
-            default: return "UNKNOWN";
+        size_t pos = sizeof(Header);
+        bool ok = true;
+        auto take = [&](size_t bytes) -> const char * {
+            if (!ok || pos > data.size() || bytes > data.size() - pos) {
+                ok = false;
+                return nullptr;
+            }
+            const char *p = data.data() + pos;
+            pos += (bytes + 7) & ~(size_t) 7;
+            return p;
+        };
+        size_t S = (size_t) h.numSymbols, R = (size_t) h.numRules, L = (size_t) h.rhsLength;
+        size_t words = S * setWords(h.numTerminals);
+        nameOffsets = (const uint32_t *) take((S + 1) * sizeof(uint32_t));
+        names = take((size_t) h.nameBytes);
+        rhsStart = (const uint32_t *) take((R + 1) * sizeof(uint32_t));
+        lhs = (const int32_t *) take(R * sizeof(int32_t));
+        rhsIds = (const int32_t *) take(L * sizeof(int32_t));
+        rhsTypes = (const uint8_t *) take(L);
+        nullable = (const uint8_t *) take(S);
+        first = (const uint64_t *) take(words * sizeof(uint64_t));
+        follow = (const uint64_t *) take(words * sizeof(uint64_t));
+        table = (const ParseCell *) take((S - h.numTerminals) * h.numTerminals * sizeof(ParseCell));
+        lookahead = (const ParseCell *) take((size_t) h.lookaheadCells * sizeof(ParseCell));
+        conflicts = (const int32_t *) take((size_t) h.numConflicts * 4 * sizeof(int32_t));
+        if (!ok || pos != data.size()) return false;
+
+        if (nameOffsets[0] != 0 || nameOffsets[S] != (uint32_t) h.nameBytes) return false;
+        for (size_t id = 0; id < S; id++) {
+            if (nameOffsets[id] > nameOffsets[id + 1]) return false;
+        }
+        if (rhsStart[0] != 0 || rhsStart[R] != L) return false;
+        for (size_t r = 0; r < R; r++) {
+            // Toda regla tiene al menos un simbolo (epsilon cuenta)
+            if (rhsStart[r] >= rhsStart[r + 1] || lhs[r] < h.numTerminals || lhs[r] >= h.numSymbols) return false;
+            // epsilon solo como RHS completa
+            if (rhsStart[r + 1] - rhsStart[r] > 1) {
+                for (uint32_t i = rhsStart[r]; i < rhsStart[r + 1]; i++) {
+                    if (rhsTypes[i] == EPSILON) return false;
+                }
+            }
+        }
+        for (size_t i = 0; i < L; i++) {
+            int id = rhsIds[i];
+            switch (rhsTypes[i]) {
+                case EPSILON: ok = id == EPSILON_ID; break;
+                case TERMINAL:
+                case DOLAR: ok = id >= 0 && id < h.numTerminals; break;
+                case NON_TERMINAL: ok = id >= h.numTerminals && id < h.numSymbols; break;
+                default: ok = false;
+            }
+            if (!ok) return false;
         }
+        return true;
     }
 };
 
-class Scanner {
-    private:
-        string input;
-        int first, current;
+class Grammar {
     public:
-        explicit Scanner(const char *s){
-            input = s;
-            first = 0;
-            current = 0;
-        }
-        Token *nextToken(){
-            Token *token;
-
-    while (input[current] == ' ')
-        current++;
-
-    if (input[current] == '\0')
-        return new Token(Token::END);
-
-    char c = input[current];
-    first = current;
-    if (isdigit(c)) {
-        current++;
-        while (isdigit(input[current])) {
-            current++;
-            }
-        token = new Token(Token::NUM, input.substr(first, current-first));
-    } else if (isalpha(c)) {
-        current++;
-        while (isalnum(input[current])){
-            current++;
-        }
-        if (input.substr(first, current - first) == "print"){
-            token = new Token(Token::PRINT, input.substr(first, current - first));
-            }
-        else{
-            token = new Token(Token::ID, input.substr(first, current - first));
-            }
-    } else if (strchr("+-*()=;", c)) {
-        switch (c) {
-            case '=':
-                token = new Token(Token::ASSIGN, c);
-                break;
-            case ';':
-                token = new Token(Token::SEMI, c);
-                break;
-            case '+':
-                token = new Token(Token::PLUS, c);
-                break;
-            case '-':
-                token = new Token(Token::MIN, c);
-                break;
-            case '*':
-                token = new Token(Token::MUL, c);
-                break;
-            case '(':
-                token = new Token(Token::LP, c);
-                break;
-            case ')':
-                token = new Token(Token::RP, c);
-                break;
-            default:
-                token = new Token(Token::ERR, c);
-                cout << "Caracter invalido: " << c << endl;
-        }
-        current++;
-    } else {
-        token = new Token(Token::ERR, c);
-    }
-    return token;
-        }
-
-        ~Scanner(){
-            // delete[] input;
-        }
-
-        [[nodiscard]] string getInput() const {
-            return input;}
-};
-
-
-class Parser {
-private:
-    Grammar *grammar;
-    Scanner *scanner;
-    Token *currentToken;
-    unordered_map<string, unordered_map<string, int>> parseTable;
-
-public:
+        vector<ProdRule> rules;
+        // Tabla de simbolos: los terminales ocupan [0, numTerminals), con $ en 0,
+        // y los no terminales [numTerminals, numSymbols), con el inicial primero
+        vector<string> symbolNames;
+        unordered_map<string, int> symbolIds;
+        int numTerminals = 0;
+        // NULLABLE, FIRST y FOLLOW indexados por ID de simbolo
+        vector<char> NULLABLE;
+        // No terminales que derivan alguna cadena de terminales (ver calcProductive)
+        vector<char> PRODUCTIVE;
+        vector<TermSet> FIRST;
+        vector<TermSet> FOLLOW;
+        // Tabla LL(1) precalculada (StaticTables o la cache en disco), o nullptr
+        // si hay que construirla
+        const ParseCell *staticTable = nullptr;
+        // Archivo de la cache que contiene staticTable, si la gramatica se leyo de ahi
+        shared_ptr<const MappedFile> mapping;
 
-    // Constructor
-    Parser(Scanner *s, Grammar *g) {
-        this->scanner = s;
-        this->grammar = g;
-        this->currentToken = nullptr;
-        // Llamamos a la funcion para construir la tabla de parseo
-        buildParseTable();
-    }
+        Grammar() = default;
+        // Las reglas pueden tener recursion por izquierda y prefijos comunes:
+        // GrammarTransform las lleva a forma LL(1) antes de calcular los conjuntos
+        Grammar(vector<ProdRule> r){
+            rules = std::move(r);
+            internSymbols();
+            if (GrammarTransform(rules, symbolNames, numTerminals).apply(rules)) internSymbols();
 
-    // Funcion que construye la tabla de parseo
-    void buildParseTable() {
-        // Inicializamos la tabla de parseo con valores -1
-        for (const string &nonTerm : grammar->nonTerminals) {
-            for (const string &term : grammar->terminals) {
-                parseTable[nonTerm][term] = -1;
-            }
+            calcNullable();
+            calcProductive();
+            calcFirst();
+            calcFollow();
         }
 
-        // Para cada regla de produccion, procesamos la RHS
-        for (const ProdRule &rule : grammar->rules) {
-            vector<Symbol> symbvec;
-            vector<Symbol> thisrhs = rule.rhs;
-            bool alert = false;
-            
-
-            // Recorremos los simbolos de la RHS
-            for (auto &sym : thisrhs) {
-                if (sym.type == TERMINAL) {
-                    symbvec.push_back(sym);
-                    alert = true;
-                    break;
+        // Gramatica con los conjuntos y la tabla ya calculados en tiempo de
+        // compilacion: solo arma la tabla de simbolos y las reglas
+        template <int T, int N, int R>
+        Grammar(const StaticGrammar<T, N, R> &g, const StaticTables<T, N, R> &tables){
+            for (int id = 0; id < T + N; id++) {
+                symbolNames.push_back(g.names[id]);
+                symbolIds[g.names[id]] = id;
+            }
+            numTerminals = T;
+            for (const StaticRule &rule : g.rules) {
+                vector<Symbol> rhs;
+                for (int i = 0; i < rule.length; i++) {
+                    rhs.emplace_back(g.names[rule.rhs[i]], rule.rhs[i] < T ? TERMINAL : NON_TERMINAL);
                 }
+                if (rule.length == 0) rhs.emplace_back("epsilon", EPSILON);
+                rules.emplace_back(g.names[rule.lhs], rhs);
+            }
+            indexRules();
+            calcProductive();
+
+            NULLABLE.assign(tables.nullable.begin(), tables.nullable.end());
+            FIRST.assign(T + N, TermSet(T));
+            FOLLOW.assign(T + N, TermSet(T));
+            for (int id = 0; id < T + N; id++) {
+                FIRST[id].words[0] = tables.first[id];
+                FOLLOW[id].words[0] = tables.follow[id];
+            }
+            staticTable = tables.table.data();
+        }
 
-                SetSym symbolFirstSet = grammar->FIRST[sym.value];
-                bool containsEps = false;
-                for (const Symbol &s : symbolFirstSet) {
-                    if (s.type == EPSILON) {
-                        containsEps = true;
-                        break;
-                    }
-                }
-                
-                if (!containsEps) {
-                    symbvec.insert(symbvec.end(), symbolFirstSet.begin(), symbolFirstSet.end());
-                    alert = true;
-                    break;
+        // Gramatica leida de la cache en disco (ver CompiledGrammar::load): arma
+        // la tabla de simbolos y las reglas, copia los conjuntos y deja la tabla
+        // LL(1) en el archivo mapeado, que file mantiene vivo
+        Grammar(const GrammarImage &image, shared_ptr<const MappedFile> file){
+            const GrammarImage::Header &h = image.header;
+            symbolNames.reserve(h.numSymbols);
+            for (int id = 0; id < h.numSymbols; id++) {
+                symbolNames.emplace_back(image.names + image.nameOffsets[id], image.nameOffsets[id + 1] - image.nameOffsets[id]);
+                symbolIds[symbolNames.back()] = id;
+            }
+            numTerminals = h.numTerminals;
+            // Los IDs ya estan resueltos en la imagen: no hace falta indexRules()
+            rules.reserve(h.numRules);
+            rulesByLhs.assign(h.numSymbols, vector<int>());
+            for (int r = 0; r < h.numRules; r++) {
+                vector<Symbol> rhs;
+                rhs.reserve(image.rhsStart[r + 1] - image.rhsStart[r]);
+                for (uint32_t i = image.rhsStart[r]; i < image.rhsStart[r + 1]; i++) {
+                    Type type = (Type) image.rhsTypes[i];
+                    rhs.emplace_back(type == EPSILON ? "epsilon" : symbolNames[image.rhsIds[i]], type);
+                    rhs.back().id = image.rhsIds[i];
                 }
+                rules.emplace_back(symbolNames[image.lhs[r]], std::move(rhs));
+                rules.back().lhsId = image.lhs[r];
+                rulesByLhs[image.lhs[r]].push_back(r);
             }
 
-            // Si no hemos terminado, agregamos FOLLOW
-            if (!alert) {
-                SetSym &follow = grammar->FOLLOW[rule.lhs];
-                symbvec.insert(symbvec.end(), follow.begin(), follow.end());
+            calcProductive();
+            NULLABLE.assign(image.nullable, image.nullable + h.numSymbols);
+            int words = GrammarImage::setWords(numTerminals);
+            FIRST.assign(h.numSymbols, TermSet(numTerminals));
+            FOLLOW.assign(h.numSymbols, TermSet(numTerminals));
+            for (int id = 0; id < h.numSymbols; id++) {
+                copy_n(image.first + (size_t) id * words, words, FIRST[id].words.begin());
+                copy_n(image.follow + (size_t) id * words, words, FOLLOW[id].words.begin());
             }
+            staticTable = image.table;
+            mapping = std::move(file);
+        }
 
-            // Insertamos las reglas en la tabla de parseo
-            for (const Symbol &sym : symbvec) {
-                bool foundInTable = parseTable[rule.lhs].find(sym.value) != parseTable[rule.lhs].end();
-                bool isValidEntry = (foundInTable && parseTable[rule.lhs][sym.value] != -1);
+        int symbolCount() const {
+            return (int) symbolNames.size();
+        }
 
-                if (isValidEntry) {
-                    cout << "Gramatica no es LL1!" << endl;
-                    exit(1);
-                }
+        int nonTerminalCount() const {
+            return symbolCount() - numTerminals;
+        }
 
-                string terminalStr;
-                if (sym.value == "$") {
-                    terminalStr = "epsilon";
-                } else {
-                    terminalStr = sym.value;
-                }
+        bool isTerminal(int id) const {
+            return id < numTerminals;
+        }
 
-                int ruleIndex = 0;
-                for (auto it = grammar->grammarRules().begin(); it != grammar->grammarRules().end(); ++it, ++ruleIndex) {
-                    if (*it == rule) {
-                        break;
-                    }
-                }
+        int startSymbol() const {
+            return rules[0].lhsId;
+        }
 
-                parseTable[rule.lhs][terminalStr] = ruleIndex;
-            }
+        bool productive(int id) const {
+            return isTerminal(id) || PRODUCTIVE[id];
         }
 
-        // Revisamos si hay sincronización
-        for (auto &parseTableRow : parseTable) {
-            const SetSym &currentFollow = grammar->FOLLOW[parseTableRow.first];
-            
-            for (auto &parseTableCol : parseTableRow.second) {
-                if (parseTableCol.second != -1) continue;
-
-                bool isInFollowSet = false;
-                
-                // Recorremos el conjunto FOLLOW
-                for (const Symbol &s : currentFollow) {
-                    string symValue = (s.value == "$") ? "epsilon" : s.value;
-                    if (symValue == parseTableCol.first) {
-                        isInFollowSet = true;
-                        break;
-                    }
-                }
+        // Hash FNV-1a de las reglas (nombres y tipos de simbolos, en orden); sirve
+        // para detectar si un artefacto generado corresponde a esta gramatica
+        uint64_t fingerprint() const {
+            return fingerprint(rules);
+        }
 
-                parseTableCol.second = isInFollowSet ? -2 : -1;
+        // Hash de un conjunto de reglas por nombre; sirve tambien para reglas que
+        // todavia no pasaron por Grammar (la clave de la cache en disco)
+        static uint64_t fingerprint(const vector<ProdRule> &rules) {
+            uint64_t h = 1469598103934665603ull;
+            auto mix = [&h](const string &text, int tag) {
+                for (unsigned char c : text) h = (h ^ c) * 1099511628211ull;
+                h = (h ^ (unsigned) (tag + 1)) * 1099511628211ull;
+            };
+            for (const auto &rule: rules) {
+                mix(rule.lhs, -1);
+                for (const auto &symbol: rule.rhs) mix(symbol.value, symbol.type);
             }
+            return h;
         }
 
-    }
-
-    // Modulo para realizar el match
-    void match(const string &top, size_t &start) {
-        cout << "accion: match " << top << " : " << currentToken->lexeme << endl;
-        start += currentToken->lexeme.size();  // Avanzamos en el input
-        currentToken = scanner->nextToken();  // Obtenemos el siguiente token
-    }
+        const string &name(int id) const {
+            return symbolNames[id];
+        }
 
-    // Funcion principal de parseo
-    void parse() {
-        currentToken = scanner->nextToken();  // Obtenemos el primer token
-        stack<string> parseStack;
-        vector<string> parseStackVec;
+        // Devuelve el ID del simbolo o -1 si no pertenece a la gramatica
+        int symbolId(const string &symbol) const {
+            auto it = symbolIds.find(symbol);
+            return it == symbolIds.end() ? -1 : it->second;
+        }
 
-        // Inicializamos el stack con el simbolo inicial y $
-        parseStack.emplace("$");
-        parseStackVec.emplace_back("$");
-        parseStack.push(grammar->grammarRules()[0].lhs);
-        parseStackVec.push_back(grammar->grammarRules()[0].lhs);
+        const vector<ProdRule> &grammarRules() const {
+            return rules;
+        }
 
-        unordered_set<string> syncSet = {"$", "epsilon", ";", ")"};
-        string inputString = this->scanner->getInput() + "$";
+        // Indices de las reglas con el no terminal dado como LHS
+        const vector<int> &rulesFor(int lhs) const {
+            return rulesByLhs[lhs];
+        }
 
-        string newString;
-        
-        for (char c : inputString) {
-            if (!isspace(c)) {
-                newString += c;
+        // FIRST de una secuencia de simbolos; nullable indica si deriva epsilon
+        TermSet calcFirst(const vector<Symbol> &rhs, bool &nullable) const {
+            TermSet firstSet(numTerminals);
+            nullable = true;
+            for (const auto &symbol: rhs) {
+                if (symbol.type == EPSILON) continue;
+                firstSet.unionWith(FIRST[symbol.id]);
+                if (!NULLABLE[symbol.id]) {
+                    nullable = false;
+                    break;
+                }
             }
+            return firstSet;
         }
-        inputString = newString;
 
+    private:
+        //calculamos los no terminales que derivan epsilon con una lista de trabajo:
+        //cada regla cuenta sus simbolos que aun no sabemos si son nullables
+        void calcNullable(){
+            NULLABLE = derivable(false);
+        }
 
-        size_t start = 0;  // Marca el comienzo del input
+        //los productivos derivan alguna cadena de terminales; con el inicial no
+        //productivo el lenguaje es vacio
+        void calcProductive(){
+            PRODUCTIVE = derivable(true);
+        }
 
-        // Ciclo principal del parseo
-        while (!parseStack.empty()) {
-            string top = parseStack.top();
-            string tokenStr = currentToken->toString();
+        // No terminales con alguna regla cuyos simbolos ya se sabe que derivan lo
+        // pedido: epsilon o, con terminals, cualquier cadena de terminales
+        vector<char> derivable(bool terminals) const {
+            vector<char> done(symbolCount(), false);
+            vector<int> pending(rules.size(), 0);
+            vector<vector<int>> occurrences(symbolCount());
+            vector<int> worklist;
+
+            for (int r = 0; r < (int) rules.size(); r++) {
+                for (const auto &symbol: rules[r].rhs) {
+                    if (symbol.type == EPSILON || (terminals && symbol.type != NON_TERMINAL)) continue;
+                    pending[r]++;
+                    if (symbol.type == NON_TERMINAL) occurrences[symbol.id].push_back(r);
+                }
+                if (pending[r] == 0 && !done[rules[r].lhsId]) {
+                    done[rules[r].lhsId] = true;
+                    worklist.push_back(rules[r].lhsId);
+                }
+            }
 
-            cout << "----------------------------------------\n";
-            cout << "stack: ";
-            for (string &s : parseStackVec) {
-                cout << s << " ";
+            while (!worklist.empty()) {
+                int nonTerm = worklist.back();
+                worklist.pop_back();
+                for (int r : occurrences[nonTerm]) {
+                    if (--pending[r] == 0 && !done[rules[r].lhsId]) {
+                        done[rules[r].lhsId] = true;
+                        worklist.push_back(rules[r].lhsId);
+                    }
+                }
             }
-            cout << endl;
+            return done;
+        }
 
-            cout << "input: " << inputString.substr(start) << endl;
+        //calculamos el first como punto fijo: FIRST(Y) fluye hacia FIRST(X)
+        //por cada regla X -> a Y b con a nullable
+        void calcFirst(){
+            FIRST.assign(symbolCount(), TermSet(numTerminals));
+            for (int t = 0; t < numTerminals; t++) FIRST[t].insert(t);
 
-            if (top == "$") {
-                // Si llegamos al final del stack y aun hay tokens, hay un error
-                if (currentToken->type != Token::END) {
-                    cerr << "Input no vacio, stack terminado" << endl;
-                    exit(1);
+            vector<vector<int>> dependents(symbolCount());
+            for (const auto &rule: rules) {
+                for (const auto &symbol: rule.rhs) {
+                    if (symbol.type == EPSILON) continue;
+                    if (symbol.type == NON_TERMINAL) dependents[symbol.id].push_back(rule.lhsId);
+                    else FIRST[rule.lhsId].insert(symbol.id);
+                    if (!NULLABLE[symbol.id]) break;
                 }
-                cout << "Exitoso!" << endl;
-                return;
             }
+            propagate(FIRST, dependents);
+        }
 
-            // Si el tope del stack es terminal
-            if (Grammar::isTerminal(top)) {
-                if (top == tokenStr) {
-                    match(top, start);  // Llamamos a la funcion modularizada
-                    parseStack.pop();
-                    parseStackVec.pop_back();
-                } else {
-                    handleError(top, tokenStr, parseStack, parseStackVec, syncSet, start);
+        //calculamos el follow como punto fijo: para A -> a B b, FIRST(b) entra en
+        //FOLLOW(B) y, si b es nullable, FOLLOW(A) fluye hacia FOLLOW(B)
+        void calcFollow(){
+            FOLLOW.assign(symbolCount(), TermSet(numTerminals));
+            FOLLOW[startSymbol()].insert(END_ID);
+
+            vector<vector<int>> dependents(symbolCount());
+            TermSet suffixFirst(numTerminals);
+            for (const auto &rule: rules) {
+                // Recorremos la RHS de derecha a izquierda acumulando FIRST del sufijo
+                fill(suffixFirst.words.begin(), suffixFirst.words.end(), 0);
+                bool suffixNullable = true;
+                for (int i = (int) rule.rhs.size() - 1; i >= 0; i--) {
+                    const Symbol &symbol = rule.rhs[i];
+                    if (symbol.type == EPSILON) continue;
+                    if (symbol.type == NON_TERMINAL) {
+                        FOLLOW[symbol.id].unionWith(suffixFirst);
+                        if (suffixNullable && symbol.id != rule.lhsId) {
+                            dependents[rule.lhsId].push_back(symbol.id);
+                        }
+                    }
+                    if (!NULLABLE[symbol.id]) {
+                        fill(suffixFirst.words.begin(), suffixFirst.words.end(), 0);
+                        suffixNullable = false;
+                    }
+                    suffixFirst.unionWith(FIRST[symbol.id]);
                 }
-            } else {
-                applyRule(top, tokenStr, parseStack, parseStackVec, start);
             }
+            propagate(FOLLOW, dependents);
         }
-    }
 
-    // Funcion para manejar errores de sintaxis
-    void handleError(const string &top, const string &tokenStr, stack<string> &parseStack, vector<string> &parseStackVec, const unordered_set<string> &syncSet, size_t &start) {
-        cout << "----------------------------------------\n";
-        cout << "Error de sintaxis, se esperaba: " << top << ". Se obtuvo: " << tokenStr << endl;
-        bool syncFound = syncSet.find(tokenStr) == syncSet.end();
-        while (currentToken->type != Token::END && syncFound) {
-            cout << "skip token. " << currentToken->toString() << endl;
-            start += currentToken->lexeme.size();
-            currentToken = scanner->nextToken();
-            syncFound = syncSet.find(currentToken->toString()) == syncSet.end();
-        }
-        parseStack.pop();
-        parseStackVec.pop_back();
-    }
+        vector<vector<int>> rulesByLhs;
 
-    // Funcion que aplica la regla correspondiente
-    void applyRule(const string &top, const string &tokenStr, stack<string> &parseStack, vector<string> &parseStackVec, size_t &start) {
-        int ruleIdx = parseTable[top][tokenStr];
-        if (ruleIdx == -1 || ruleIdx == -2) {
-            cout << "----------------------------------------\n";
-            cout << "Error de sintaxis, token inesperado: " << tokenStr << endl;
-            if (ruleIdx == -2) {
-                cout << "Sacando... " << parseStack.top() << " del stack" << endl;
-                parseStack.pop();
-                parseStackVec.pop_back();
-            } else {
-                cout << "Skipping..." << endl;
-                start += currentToken->lexeme.size();
-                currentToken = scanner->nextToken();
+        // Propaga sets[src] hacia sets[dst] por cada arista hasta llegar al punto fijo
+        void propagate(vector<TermSet> &sets, const vector<vector<int>> &dependents){
+            vector<int> worklist;
+            vector<char> queued(symbolCount(), false);
+            for (int nonTerm = numTerminals; nonTerm < symbolCount(); nonTerm++) {
+                worklist.push_back(nonTerm);
+                queued[nonTerm] = true;
             }
-        } else {
-            ProdRule rule = grammar->grammarRules()[ruleIdx];
-            parseStack.pop();
-            parseStackVec.pop_back();
-            if (rule.rhs[0].value != "epsilon") {
-                for (int i = (int) rule.rhs.size() - 1; i >= 0; i--) {
-                    parseStack.push(rule.rhs[i].value);
-                    parseStackVec.push_back(rule.rhs[i].value);
+            while (!worklist.empty()) {
+                int src = worklist.back();
+                worklist.pop_back();
+                queued[src] = false;
+                for (int dst : dependents[src]) {
+                    if (sets[dst].unionWith(sets[src]) && !queued[dst]) {
+                        queued[dst] = true;
+                        worklist.push_back(dst);
+                    }
                 }
             }
-            cout << "accion: " << rule.lhs << " -> ";
-            for (const Symbol &sym : rule.rhs) cout << sym.value << " ";
-            cout << endl;
         }
-    }
-};
-
 
+        int intern(const string &symbol){
+            auto it = symbolIds.find(symbol);
+            if (it != symbolIds.end()) return it->second;
+            int id = (int) symbolNames.size();
+            symbolNames.push_back(symbol);
+            symbolIds[symbol] = id;
+            return id;
+        }
 
+        // Asigna un ID entero a cada terminal y no terminal, en orden de aparicion
+        void internSymbols(){
+            symbolNames.clear();
+            symbolIds.clear();
+            intern("$");
+            for (const auto &rule: rules) {
+                for (const auto &symbol: rule.rhs) {
+                    if (symbol.type == TERMINAL) intern(symbol.value);
+                }
+            }
+            numTerminals = symbolCount();
+            for (const auto &rule: rules) {
+                intern(rule.lhs);
+                for (const auto &symbol: rule.rhs) {
+                    if (symbol.type == NON_TERMINAL) intern(symbol.value);
+                }
+            }
+            indexRules();
+        }
 
+        // Resuelve los IDs de LHS y RHS de cada regla y agrupa las reglas por LHS
+        void indexRules(){
+            rulesByLhs.assign(symbolCount(), vector<int>());
+            for (int r = 0; r < (int) rules.size(); r++) {
+                ProdRule &rule = rules[r];
+                rule.lhsId = symbolIds[rule.lhs];
+                rulesByLhs[rule.lhsId].push_back(r);
+                for (auto &symbol: rule.rhs) {
+                    if (symbol.type == TERMINAL || symbol.type == NON_TERMINAL) {
+                        symbol.id = symbolIds[symbol.value];
+                    }
+                }
+            }
+        }
 
+};
 
 
+class Token {
+public:
+    enum Type {
+        ID, NUM, ASSIGN, SEMI, LP, RP, PLUS, MIN, MUL, ERR, PRINT, END};
 
+    Type type;
+    string_view lexeme;   // vista sobre el input del scanner, sin copias
+    size_t offset;        // posicion del lexema en el input
 
+    // Constructor
+    explicit Token(Type t){
+        type = t;
+        offset = 0;
+    }
+
+    Token(Type t, string_view l, size_t off) {
+        type = t;
+        lexeme = l;
+        offset = off;
+        }
+
+    string toString() const {
+        switch (type) {
+            case ID: return "ID";
+            case NUM: return "NUM";
+            case ASSIGN: return "=";
+            case SEMI: return ";";
+            case LP: return "(";
+            case RP: return ")";
+            case PLUS: return "+";
+            case MIN: return "-";
+            case MUL: return "*";
+            case ERR: return "ERR";
+            case PRINT: return "print";
+            case END: return "epsilon";
+            default: return "UNKNOWN";
+        }
+    }
+};
+
+// Archivo mapeado en memoria de solo lectura; el sistema trae las paginas
+// a medida que el scanner avanza, sin leer el archivo completo
+class MappedFile {
+    private:
+        const char *data;
+        size_t length;
+    public:
+        MappedFile(){
+            data = nullptr;
+            length = 0;
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        // Devuelve false si el archivo no se pudo abrir o mapear
+        bool open(const char *path){
+            close();
+            int fd = ::open(path, O_RDONLY);
+            if (fd < 0) return false;
+            struct stat st{};
+            if (fstat(fd, &st) != 0) {
+                ::close(fd);
+                return false;
+            }
+            length = (size_t) st.st_size;
+            if (length > 0) {
+                void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED) {
+                    ::close(fd);
+                    length = 0;
+                    return false;
+                }
+                madvise(p, length, MADV_SEQUENTIAL);
+                data = static_cast<const char *>(p);
+            }
+            ::close(fd);
+            return true;
+        }
+
+        void close(){
+            if (data) munmap(const_cast<char *>(data), length);
+            data = nullptr;
+            length = 0;
+        }
+
+        [[nodiscard]] string_view view() const {
+            return {data, length};
+        }
+
+        ~MappedFile(){
+            close();
+        }
+};
+
+// Clases de caracter para el scanner: una consulta a la tabla reemplaza
+// isdigit/isalnum/strchr en el ciclo caliente
+enum CharClass : uint8_t {
+    CC_SPACE = 1,
+    CC_DIGIT = 2,
+    CC_ALPHA = 4,
+    CC_PUNCT = 8
+};
+
+struct CharTables {
+    uint8_t charClass[256];
+    uint8_t punctToken[256];   // Token::Type de cada caracter de puntuacion
+};
+
+constexpr CharTables makeCharTables() {
+    CharTables t{};
+    for (int c = 0; c < 256; c++) {
+        t.charClass[c] = 0;
+        t.punctToken[c] = Token::ERR;
+    }
+    for (char c : {' ', '\t', '\n', '\r'}) t.charClass[(unsigned char) c] = CC_SPACE;
+    for (int c = '0'; c <= '9'; c++) t.charClass[c] = CC_DIGIT;
+    for (int c = 'a'; c <= 'z'; c++) t.charClass[c] = CC_ALPHA;
+    for (int c = 'A'; c <= 'Z'; c++) t.charClass[c] = CC_ALPHA;
+    const char punct[] = "=;+-*()";
+    const Token::Type punctTypes[] = {Token::ASSIGN, Token::SEMI, Token::PLUS, Token::MIN, Token::MUL, Token::LP, Token::RP};
+    for (int i = 0; i < 7; i++) {
+        t.charClass[(unsigned char) punct[i]] = CC_PUNCT;
+        t.punctToken[(unsigned char) punct[i]] = punctTypes[i];
+    }
+    return t;
+}
+
+constexpr CharTables CHAR_TABLES = makeCharTables();
+
+inline bool hasClass(char c, uint8_t cls) {
+    return CHAR_TABLES.charClass[(unsigned char) c] & cls;
+}
+
+// Funciones que avanzan sobre una corrida de caracteres de una clase y devuelven
+// el primer caracter fuera de ella. Hay versiones escalar, SSE2 y AVX2.
+struct LexKernels {
+    const char *name;
+    const char *(*skipSpaces)(const char *p, const char *end);
+    const char *(*skipAlnum)(const char *p, const char *end);
+    const char *(*skipDigits)(const char *p, const char *end);
+};
+
+inline const char *scalarSkip(const char *p, const char *end, uint8_t cls) {
+    while (p < end && hasClass(*p, cls)) p++;
+    return p;
+}
+
+inline LexKernels scalarLexKernels() {
+    return {
+        "scalar",
+        [](const char *p, const char *end) { return scalarSkip(p, end, CC_SPACE); },
+        [](const char *p, const char *end) { return scalarSkip(p, end, CC_ALPHA | CC_DIGIT); },
+        [](const char *p, const char *end) { return scalarSkip(p, end, CC_DIGIT); }
+    };
+}
+
+#if defined(__x86_64__)
+
+// Mascara de bytes en [lo, hi]: se desplaza el rango para usar una comparacion con signo
+#define LEX_IN_RANGE(W, v, lo, hi) \
+    _mm##W##_cmpgt_epi8(_mm##W##_set1_epi8((char) (-128 + ((hi) - (lo) + 1))), \
+                        _mm##W##_add_epi8(v, _mm##W##_set1_epi8((char) (0x80 - (lo)))))
+
+inline __m128i sse2SpaceMask(__m128i v) {
+    __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+    return _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+}
+
+inline __m128i sse2DigitMask(__m128i v) {
+    return LEX_IN_RANGE(, v, '0', '9');
+}
+
+inline __m128i sse2AlnumMask(__m128i v) {
+    // (c | 0x20) lleva las mayusculas a minusculas
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    return _mm_or_si128(LEX_IN_RANGE(, v, '0', '9'), LEX_IN_RANGE(, lower, 'a', 'z'));
+}
+
+template <__m128i (*Mask)(__m128i), uint8_t Cls>
+const char *sse2Skip(const char *p, const char *end) {
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        unsigned outside = ~(unsigned) _mm_movemask_epi8(Mask(v)) & 0xFFFF;
+        if (outside) return p + __builtin_ctz(outside);
+        p += 16;
+    }
+    return scalarSkip(p, end, Cls);
+}
+
+inline LexKernels sse2LexKernels() {
+    return {"sse2", sse2Skip<sse2SpaceMask, CC_SPACE>, sse2Skip<sse2AlnumMask, CC_ALPHA | CC_DIGIT>,
+            sse2Skip<sse2DigitMask, CC_DIGIT>};
+}
+
+__attribute__((target("avx2"))) inline __m256i avx2SpaceMask(__m256i v) {
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+    return _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+}
+
+__attribute__((target("avx2"))) inline __m256i avx2DigitMask(__m256i v) {
+    return LEX_IN_RANGE(256, v, '0', '9');
+}
+
+__attribute__((target("avx2"))) inline __m256i avx2AlnumMask(__m256i v) {
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    return _mm256_or_si256(LEX_IN_RANGE(256, v, '0', '9'), LEX_IN_RANGE(256, lower, 'a', 'z'));
+}
+
+template <__m256i (*Mask)(__m256i), __m128i (*Mask128)(__m128i), uint8_t Cls>
+__attribute__((target("avx2"))) const char *avx2Skip(const char *p, const char *end) {
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        unsigned outside = ~(unsigned) _mm256_movemask_epi8(Mask(v));
+        if (outside) return p + __builtin_ctz(outside);
+        p += 32;
+    }
+    return sse2Skip<Mask128, Cls>(p, end);
+}
+
+inline LexKernels avx2LexKernels() {
+    return {"avx2", avx2Skip<avx2SpaceMask, sse2SpaceMask, CC_SPACE>,
+            avx2Skip<avx2AlnumMask, sse2AlnumMask, CC_ALPHA | CC_DIGIT>,
+            avx2Skip<avx2DigitMask, sse2DigitMask, CC_DIGIT>};
+}
+
+#undef LEX_IN_RANGE
+
+#endif
+
+// Elige una sola vez la version por defecto. Es SSE2 aunque el CPU tenga AVX2:
+// en codigo real las corridas (identificadores, indentacion) son mas cortas que
+// 32 bytes, AVX2 casi siempre termina en el camino de SSE2 y el escalar, y en el
+// bench del scanner (seccion "scanner") queda por debajo de SSE2, sobre todo con
+// el programa formateado. Para inputs con corridas largas se puede pedir con
+// Scanner::useKernels(avx2LexKernels()) despues de verificar el CPU.
+inline const LexKernels &selectLexKernels() {
+    static const LexKernels kernels = [] {
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")) return sse2LexKernels();
+#endif
+        return scalarLexKernels();
+    }();
+    return kernels;
+}
+
+// Contadores del scanner. Se actualizan una vez por lote en fill(), asi
+// nextToken() no cambia; sin perfil activo el costo es una comparacion por lote.
+struct ScanProfile {
+    array<uint64_t, Token::END + 1> tokens{};   // tokens producidos por Token::Type
+    uint64_t bytes = 0;
+    uint64_t nanos = 0;
+
+    void merge(const ScanProfile &other) {
+        for (size_t t = 0; t < tokens.size(); t++) tokens[t] += other.tokens[t];
+        bytes += other.bytes;
+        nanos += other.nanos;
+    }
+};
+
+class Scanner {
+    private:
+        string_view input;   // el scanner no copia el input; quien lo crea lo mantiene vivo
+        size_t first, current;
+        LexKernels kernels;
+        ScanProfile *profile = nullptr;
+    public:
+        explicit Scanner(const char *s) : Scanner(string_view(s)) {}
+        explicit Scanner(const MappedFile &file) : Scanner(file.view()) {}
+        // Escanea s desde el offset begin; los offsets de los tokens son relativos a s
+        explicit Scanner(string_view s, size_t begin = 0){
+            input = s;
+            first = begin;
+            current = begin;
+            kernels = selectLexKernels();
+        }
+
+        // Apunta el scanner a otro input sin cambiar los kernels ni el perfil
+        void reset(string_view s, size_t begin = 0){
+            input = s;
+            first = begin;
+            current = begin;
+        }
+
+        // Permite forzar una version de los kernels (p. ej. escalar para comparar)
+        void useKernels(const LexKernels &k){
+            kernels = k;
+        }
+
+        // Devuelve el siguiente token por valor; el lexema apunta al input
+        Token nextToken(){
+            const char *base = input.data();
+            const char *end = base + input.size();
+            const char *p = base + current;
+
+            if (p < end && hasClass(*p, CC_SPACE))
+                p = kernels.skipSpaces(p + 1, end);
+
+            current = p - base;
+            if (p >= end)
+                return Token(Token::END, string_view(), input.size());
+
+            first = current;
+            uint8_t cls = CHAR_TABLES.charClass[(unsigned char) *p];
+            const char *q = p + 1;
+            Token::Type type;
+            if (cls & CC_DIGIT) {
+                if (q < end && hasClass(*q, CC_DIGIT)) q = kernels.skipDigits(q + 1, end);
+                type = Token::NUM;
+            } else if (cls & CC_ALPHA) {
+                if (q < end && hasClass(*q, CC_ALPHA | CC_DIGIT)) q = kernels.skipAlnum(q + 1, end);
+                type = (q - p == 5 && memcmp(p, "print", 5) == 0) ? Token::PRINT : Token::ID;
+            } else {
+                type = static_cast<Token::Type>(CHAR_TABLES.punctToken[(unsigned char) *p]);
+            }
+            current = q - base;
+            return Token(type, input.substr(first, current - first), first);
+        }
+
+        // Activa los contadores (nullptr los desactiva); profile debe vivir
+        // mientras el scanner produzca tokens
+        void setProfile(ScanProfile *p){
+            profile = p;
+        }
+
+        // Llena out con hasta max tokens; se detiene despues de END
+        size_t fill(Token *out, size_t max){
+            if (profile) return profiledFill(out, max);
+            size_t n = 0;
+            while (n < max) {
+                out[n] = nextToken();
+                if (out[n++].type == Token::END) break;
+            }
+            return n;
+        }
+
+        size_t profiledFill(Token *out, size_t max){
+            auto t0 = chrono::steady_clock::now();
+            size_t start = current;
+            size_t n = 0;
+            while (n < max) {
+                out[n] = nextToken();
+                if (out[n++].type == Token::END) break;
+            }
+            profile->nanos += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+            profile->bytes += current - start;
+            for (size_t i = 0; i < n; i++) profile->tokens[out[i].type]++;
+            return n;
+        }
+
+        [[nodiscard]] string_view getInput() const {
+            return input;}
+};
+
+
+struct SourceLocation {
+    size_t line;     // desde 1
+    size_t column;   // desde 1, en bytes
+};
+
+// Convierte offsets en linea/columna solo cuando se emite un diagnostico.
+// Recuerda la ultima posicion para que diagnosticos sucesivos solo cuenten
+// los saltos de linea nuevos.
+class SourceLocator {
+    private:
+        string_view input;
+        size_t offset, line, lineStart;
+    public:
+        explicit SourceLocator(string_view s = string_view()){
+            input = s;
+            offset = 0;
+            line = 1;
+            lineStart = 0;
+        }
+
+        SourceLocation locate(size_t target){
+            if (target > input.size()) target = input.size();
+            if (target < offset) {
+                offset = 0;
+                line = 1;
+                lineStart = 0;
+            }
+            const char *base = input.data();
+            while (offset < target) {
+                const void *nl = memchr(base + offset, '\n', target - offset);
+                if (!nl) break;
+                line++;
+                lineStart = static_cast<const char *>(nl) - base + 1;
+                offset = lineStart;
+            }
+            offset = target;
+            return {line, target - lineStart + 1};
+        }
+};
+
+// Buffer de tokens entre el scanner y el parser. El scanner llena lotes de
+// BATCH tokens y el parser los consume sin volver a entrar al scanner por token.
+// En modo threaded el scanner corre en otro hilo y entrega lotes por un anillo
+// SPSC (un productor, un consumidor) sin locks.
+class TokenStream {
+    public:
+        static const size_t BATCH = 4096;
+        static const size_t SLOTS = 8;
+
+    private:
+        struct Slot {
+            vector<Token> tokens;
+            size_t count = 0;
+        };
+
+        Scanner *scanner;
+        bool threaded;
+        const Token *cur;
+        const Token *last;
+        vector<Token> buffer;
+        vector<Token> spill;   // lo que quedaba de un lote y el siguiente, ver peek()
+        Token endToken;
+
+        // Modo threaded: head cuenta lotes producidos y tail lotes consumidos
+        vector<Slot> slots;
+        atomic<size_t> head;
+        atomic<size_t> tail;
+        atomic<bool> stopRequested;
+        thread producer;
+        bool holdingSlot;
+        bool finished;
+
+        void refill(){
+            if (finished) {
+                cur = &endToken;
+                last = cur + 1;
+                return;
+            }
+            if (!threaded) {
+                size_t n = scanner->fill(buffer.data(), BATCH);
+                cur = buffer.data();
+                last = cur + n;
+            } else {
+                if (holdingSlot) tail.fetch_add(1, memory_order_release);
+                size_t t = tail.load(memory_order_relaxed);
+                while (head.load(memory_order_acquire) == t) this_thread::yield();
+                const Slot &slot = slots[t % SLOTS];
+                holdingSlot = true;
+                cur = slot.tokens.data();
+                last = cur + slot.count;
+            }
+            if (last[-1].type == Token::END) {
+                finished = true;
+                endToken = last[-1];
+            }
+        }
+
+        void produce(){
+            while (!stopRequested.load(memory_order_relaxed)) {
+                size_t h = head.load(memory_order_relaxed);
+                if (h - tail.load(memory_order_acquire) == SLOTS) {
+                    this_thread::yield();
+                    continue;
+                }
+                Slot &slot = slots[h % SLOTS];
+                slot.count = scanner->fill(slot.tokens.data(), BATCH);
+                bool end = slot.tokens[slot.count - 1].type == Token::END;
+                head.store(h + 1, memory_order_release);
+                if (end) break;
+            }
+        }
 
+    public:
+        explicit TokenStream(Scanner *s) : endToken(Token::END), head(0), tail(0), stopRequested(false) {
+            scanner = s;
+            threaded = false;
+            cur = last = nullptr;
+            holdingSlot = false;
+            finished = false;
+        }
 
+        TokenStream(const TokenStream &) = delete;
+        TokenStream &operator=(const TokenStream &) = delete;
 
+        // Cambia el scanner del que se leen los tokens; no debe haber un hilo productor activo
+        void setScanner(Scanner *s){
+            stop();
+            scanner = s;
+        }
 
+        // Reinicia el buffer; en modo threaded lanza el hilo productor
+        void start(bool useThread){
+            stop();
+            threaded = useThread;
+            cur = last = nullptr;
+            holdingSlot = false;
+            finished = false;
+            if (!threaded) {
+                // El buffer se reserva una vez; fill() escribe antes de cada lectura
+                if (buffer.size() != BATCH) buffer.assign(BATCH, Token(Token::END));
+                return;
+            }
+            if (slots.empty()) {
+                slots.resize(SLOTS);
+                for (Slot &slot : slots) slot.tokens.assign(BATCH, Token(Token::END));
+            }
+            head.store(0);
+            tail.store(0);
+            stopRequested.store(false);
+            producer = thread(&TokenStream::produce, this);
+        }
 
+        // Detiene el hilo productor si sigue corriendo
+        void stop(){
+            if (producer.joinable()) {
+                stopRequested.store(true);
+                producer.join();
+            }
+        }
 
+        const Token &next(){
+            if (cur == last) refill();
+            return *cur++;
+        }
+
+        // Token i posiciones despues del que devuelve next(), sin consumirlo; pasado
+        // el fin es END. Si el lote actual no alcanza, lo que queda se junta con el
+        // lote siguiente en spill (a lo sumo una copia por lote).
+        const Token &peek(size_t i){
+            while ((size_t) (last - cur) <= i) {
+                if (finished) return endToken;
+                vector<Token> joined(cur, last);
+                refill();
+                joined.insert(joined.end(), cur, last);
+                spill.swap(joined);
+                cur = spill.data();
+                last = cur + spill.size();
+            }
+            return cur[i];
+        }
+
+        ~TokenStream(){
+            stop();
+        }
+};
+
+
+// Arena de bump-pointer para objetos T direccionados por indice. Reserva bloques
+// de CHUNK elementos que nunca se mueven; allocate(n) devuelve n elementos
+// contiguos y release() libera todo en O(1) conservando los bloques para reusarlos.
+template <class T>
+class Arena {
+    public:
+        static constexpr uint32_t CHUNK_BITS = 16;
+        static constexpr uint32_t CHUNK = 1u << CHUNK_BITS;
+
+    private:
+        vector<unique_ptr<T[]>> chunks;
+        uint32_t used;   // elementos asignados (incluye huecos al final de cada bloque)
+
+    public:
+        Arena(){
+            used = 0;
+        }
+
+        // Devuelve el indice del primer elemento; los n quedan en el mismo bloque
+        uint32_t allocate(uint32_t n){
+            uint32_t offsetInChunk = used & (CHUNK - 1);
+            if (offsetInChunk + n > CHUNK) used += CHUNK - offsetInChunk;
+            uint32_t first = used;
+            used += n;
+            while ((size_t) chunks.size() << CHUNK_BITS < used) {
+                chunks.emplace_back(new T[CHUNK]);
+            }
+            return first;
+        }
+
+        T &operator[](uint32_t idx){
+            return chunks[idx >> CHUNK_BITS][idx & (CHUNK - 1)];
+        }
+
+        const T &operator[](uint32_t idx) const {
+            return chunks[idx >> CHUNK_BITS][idx & (CHUNK - 1)];
+        }
+
+        uint32_t size() const {
+            return used;
+        }
+
+        void release(){
+            used = 0;
+        }
+};
+
+// Nodo del arbol de parseo. Los hijos de un nodo son contiguos en la arena:
+// [firstChild, firstChild + childCount)
+struct ParseNode {
+    enum Flags : uint8_t { MISSING = 1 };   // simbolo sacado del stack al recuperarse de un error
+
+    uint64_t offset;       // terminales: offset del token en el input
+    uint32_t length;       // terminales: largo del lexema
+    uint32_t firstChild;
+    uint32_t childCount;
+    int32_t symbol;
+    int32_t rule;          // no terminales: regla aplicada, -1 si no se expandio
+    uint8_t flags;
+};
+
+class ParseTree {
+    private:
+        Arena<ParseNode> nodes;
+        uint32_t rootIdx;
+
+    public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        ParseTree(){
+            rootIdx = NONE;
+        }
+
+        uint32_t root() const {
+            return rootIdx;
+        }
+
+        uint32_t size() const {
+            return nodes.size();
+        }
+
+        ParseNode &node(uint32_t idx){
+            return nodes[idx];
+        }
+
+        const ParseNode &node(uint32_t idx) const {
+            return nodes[idx];
+        }
+
+        // Reserva n nodos hermanos para el simbolo dado, sin expandir
+        uint32_t allocate(uint32_t n){
+            return nodes.allocate(n);
+        }
+
+        uint32_t makeRoot(int symbol){
+            nodes.release();
+            rootIdx = nodes.allocate(1);
+            initNode(rootIdx, symbol);
+            return rootIdx;
+        }
+
+        void initNode(uint32_t idx, int symbol){
+            ParseNode &n = nodes[idx];
+            n.offset = 0;
+            n.length = 0;
+            n.firstChild = NONE;
+            n.childCount = 0;
+            n.symbol = symbol;
+            n.rule = -1;
+            n.flags = 0;
+        }
+
+        // Libera todos los nodos en O(1)
+        void clear(){
+            nodes.release();
+            rootIdx = NONE;
+        }
+
+        void print(ostream &out, const Grammar &g, string_view source) const {
+            if (rootIdx != NONE) print(out, g, source, rootIdx, 0);
+        }
+
+    private:
+        void print(ostream &out, const Grammar &g, string_view source, uint32_t idx, int depth) const {
+            const ParseNode &n = nodes[idx];
+            out << string(depth * 2, ' ') << g.name(n.symbol);
+            if (n.flags & ParseNode::MISSING) out << " (faltante)";
+            else if (g.isTerminal(n.symbol)) out << " : " << source.substr(n.offset, n.length);
+            out << "\n";
+            for (uint32_t c = 0; c < n.childCount; c++) print(out, g, source, n.firstChild + c, depth + 1);
+        }
+};
+
+// Politicas de traza del parser. Parser recibe la politica como parametro de
+// template, asi QuietTrace no deja ni ramas ni formateo en el ciclo de parseo.
+// Una politica con WANTS_REDUCE recibe ademas reduce(regla) cuando se termina de
+// reconocer la RHS completa de una regla, lo que permite acciones semanticas.
+// Una politica con WANTS_PROFILE expone un ParseProfile en profile: el parser le
+// conecta el scanner y mide la duracion de cada parse().
+
+// Traza legible por consola (el comportamiento original)
+struct VerboseTrace {
+    static constexpr bool WANTS_REDUCE = false;
+    static constexpr bool WANTS_PROFILE = false;
+
+    string_view input;
+    SourceLocator locator;
+
+    void begin(const Grammar &, string_view source) {
+        input = source;
+        locator = SourceLocator(source);
+    }
+
+    // Muestra el stack y el input restante (sin espacios) desde el token actual;
+    // el costo de formatear se paga solo en este modo
+    void step(const Grammar &g, const vector<int> &stackVec, const Token &token) {
+        cout << "----------------------------------------\n";
+        cout << "stack: ";
+        for (int s : stackVec) {
+            cout << g.name(s) << " ";
+        }
+        cout << endl;
+
+        cout << "input: ";
+        for (size_t i = token.offset; i < input.size(); i++) {
+            if (!isspace((unsigned char) input[i])) cout << input[i];
+        }
+        cout << "$" << endl;
+    }
+
+    void match(const Grammar &g, int top, const Token &token) {
+        cout << "accion: match " << g.name(top) << " : " << token.lexeme << endl;
+    }
+
+    void apply(const Grammar &, int, const ProdRule &rule, const Token &) {
+        cout << "accion: " << rule.lhs << " -> ";
+        for (const Symbol &sym : rule.rhs) cout << sym.value << " ";
+        cout << endl;
+    }
+
+    // Se llega al fin del stack tambien despues de recuperarse de errores
+    void accept(const Token &, bool ok) {
+        if (ok) cout << "Exitoso!" << endl;
+    }
+
+    void expected(const Grammar &g, int top, const Token &token) {
+        cout << "----------------------------------------\n";
+        cout << "Error de sintaxis" << where(token) << ", se esperaba: " << g.name(top) << ". Se obtuvo: " << token.toString() << endl;
+    }
+
+    void unexpected(const Token &token) {
+        cout << "----------------------------------------\n";
+        cout << "Error de sintaxis" << where(token) << ", token inesperado: " << token.toString() << endl;
+    }
+
+    void skip(const Token &) {
+        cout << "Skipping..." << endl;
+    }
+
+    void pop(const Grammar &g, int top, const Token &) {
+        cout << "Sacando... " << g.name(top) << " del stack" << endl;
+    }
+
+    void trailingInput(const Token &token) {
+        cerr << "Input no vacio, stack terminado" << where(token) << endl;
+    }
+
+    string where(const Token &token) {
+        SourceLocation loc = locator.locate(token.offset);
+        return " en linea " + to_string(loc.line) + ", columna " + to_string(loc.column);
+    }
+};
+
+// Sin traza: todas las funciones son vacias y el compilador las elimina
+struct QuietTrace {
+    static constexpr bool WANTS_REDUCE = false;
+    static constexpr bool WANTS_PROFILE = false;
+
+    void begin(const Grammar &, string_view) {}
+    void step(const Grammar &, const vector<int> &, const Token &) {}
+    void match(const Grammar &, int, const Token &) {}
+    void apply(const Grammar &, int, const ProdRule &, const Token &) {}
+    void accept(const Token &, bool) {}
+    void expected(const Grammar &, int, const Token &) {}
+    void unexpected(const Token &) {}
+    void skip(const Token &) {}
+    void pop(const Grammar &, int, const Token &) {}
+    void trailingInput(const Token &) {}
+};
+
+// Evento compacto de la traza binaria
+struct TraceEvent {
+    enum Action : uint8_t { MATCH, APPLY, ACCEPT, EXPECTED, UNEXPECTED, SKIP, POP, TRAILING };
+
+    uint64_t offset;   // offset del token actual en el input
+    int32_t value;     // indice de regla (APPLY) o ID de simbolo (MATCH, EXPECTED, POP); -1 si no aplica
+    Action action;
+};
+
+// Registro binario de eventos (accion, regla/simbolo, offset) sin formatear nada
+struct EventLogTrace {
+    static constexpr bool WANTS_REDUCE = false;
+    static constexpr bool WANTS_PROFILE = false;
+
+    vector<TraceEvent> events;
+
+    void record(TraceEvent::Action action, int32_t value, size_t offset) {
+        events.push_back({(uint64_t) offset, value, action});
+    }
+
+    void begin(const Grammar &, string_view) { events.clear(); }
+    void step(const Grammar &, const vector<int> &, const Token &) {}
+    void match(const Grammar &, int top, const Token &token) { record(TraceEvent::MATCH, top, token.offset); }
+    void apply(const Grammar &, int ruleIdx, const ProdRule &, const Token &token) { record(TraceEvent::APPLY, ruleIdx, token.offset); }
+    void accept(const Token &token, bool) { record(TraceEvent::ACCEPT, -1, token.offset); }
+    void expected(const Grammar &, int top, const Token &token) { record(TraceEvent::EXPECTED, top, token.offset); }
+    void unexpected(const Token &token) { record(TraceEvent::UNEXPECTED, -1, token.offset); }
+    void skip(const Token &token) { record(TraceEvent::SKIP, -1, token.offset); }
+    void pop(const Grammar &, int top, const Token &token) { record(TraceEvent::POP, top, token.offset); }
+    void trailingInput(const Token &token) { record(TraceEvent::TRAILING, -1, token.offset); }
+};
+
+// Contadores del parser: reglas aplicadas, profundidad del stack, recuperacion
+// de errores y tiempos. Cada hilo llena el suyo sin sincronizacion; se juntan
+// con merge() o con un ProfileAggregator.
+struct ParseProfile {
+    ScanProfile scan;
+    vector<uint64_t> ruleApplications;   // por indice de regla
+    uint64_t matches = 0;
+    uint64_t maxStackDepth = 0;
+    uint64_t errors = 0;           // errores reportados
+    uint64_t recoverySkips = 0;    // tokens descartados en modo panico
+    uint64_t recoveryPops = 0;     // no terminales sacados del stack sin reconocer
+    uint64_t parses = 0;
+    uint64_t totalNanos = 0;       // parse() completo, lexing incluido
+
+    void merge(const ParseProfile &other) {
+        scan.merge(other.scan);
+        if (ruleApplications.size() < other.ruleApplications.size()) {
+            ruleApplications.resize(other.ruleApplications.size());
+        }
+        for (size_t r = 0; r < other.ruleApplications.size(); r++) ruleApplications[r] += other.ruleApplications[r];
+        matches += other.matches;
+        maxStackDepth = max(maxStackDepth, other.maxStackDepth);
+        errors += other.errors;
+        recoverySkips += other.recoverySkips;
+        recoveryPops += other.recoveryPops;
+        parses += other.parses;
+        totalNanos += other.totalNanos;
+    }
+
+    // Tiempo fuera del scanner. Con lexing en otro hilo el scanner corre en
+    // paralelo y esta resta no tiene sentido; usar totalNanos.
+    uint64_t parseNanos() const {
+        return totalNanos > scan.nanos ? totalNanos - scan.nanos : 0;
+    }
+
+    // Reglas ordenadas de la mas aplicada a la menos, sin las que no se usaron
+    vector<int> hotRules() const {
+        vector<int> order;
+        for (size_t r = 0; r < ruleApplications.size(); r++) {
+            if (ruleApplications[r]) order.push_back((int) r);
+        }
+        stable_sort(order.begin(), order.end(),
+                    [&](int a, int b) { return ruleApplications[a] > ruleApplications[b]; });
+        return order;
+    }
+
+    void print(ostream &out, const Grammar &g, size_t topRules = 10) const {
+        out << "parseos: " << parses << ", total " << totalNanos / 1e6 << " ms (lexing " << scan.nanos / 1e6
+            << " ms, parseo " << parseNanos() / 1e6 << " ms)" << endl;
+        out << "tokens:";
+        for (size_t t = 0; t < scan.tokens.size(); t++) {
+            if (scan.tokens[t]) out << " " << Token((Token::Type) t).toString() << ":" << scan.tokens[t];
+        }
+        out << " (" << scan.bytes << " bytes)" << endl;
+        out << "match: " << matches << ", stack maximo: " << maxStackDepth << endl;
+        out << "errores: " << errors << ", tokens descartados: " << recoverySkips
+            << ", no terminales sacados: " << recoveryPops << endl;
+        out << "reglas mas aplicadas:" << endl;
+        vector<int> hot = hotRules();
+        for (size_t i = 0; i < hot.size() && i < topRules; i++) {
+            const ProdRule &rule = g.rules[hot[i]];
+            out << "  " << ruleApplications[hot[i]] << "  " << rule.lhs << " ->";
+            for (const Symbol &sym : rule.rhs) out << " " << sym.value;
+            out << endl;
+        }
+    }
+
+    void printJson(ostream &out, const Grammar &g) const {
+        out << "{\"parses\": " << parses << ", \"total_ns\": " << totalNanos << ", \"lex_ns\": " << scan.nanos
+            << ", \"bytes\": " << scan.bytes << ", \"matches\": " << matches
+            << ", \"max_stack_depth\": " << maxStackDepth << ", \"errors\": " << errors
+            << ", \"recovery_skips\": " << recoverySkips << ", \"recovery_pops\": " << recoveryPops;
+        out << ", \"tokens\": {";
+        for (size_t t = 0; t < scan.tokens.size(); t++) {
+            out << (t ? ", " : "") << "\"" << Token((Token::Type) t).toString() << "\": " << scan.tokens[t];
+        }
+        out << "}, \"rules\": [";
+        for (size_t r = 0; r < ruleApplications.size(); r++) {
+            const ProdRule &rule = g.rules[r];
+            out << (r ? ", " : "") << "{\"rule\": \"" << rule.lhs << " ->";
+            for (const Symbol &sym : rule.rhs) out << " " << sym.value;
+            out << "\", \"count\": " << ruleApplications[r] << "}";
+        }
+        out << "]}" << endl;
+    }
+};
+
+// Perfil compartido entre hilos: cada parser junta sus contadores locales y los
+// publica al terminar, asi el ciclo de parseo nunca toma el lock
+class ProfileAggregator {
+    private:
+        mutable mutex m;
+        ParseProfile total;
+
+    public:
+        void add(const ParseProfile &profile) {
+            lock_guard<mutex> lock(m);
+            total.merge(profile);
+        }
+
+        ParseProfile snapshot() const {
+            lock_guard<mutex> lock(m);
+            return total;
+        }
+
+        void reset() {
+            lock_guard<mutex> lock(m);
+            total = ParseProfile();
+        }
+};
+
+// Traza que solo cuenta; los contadores se acumulan entre llamadas a parse()
+struct ProfileTrace {
+    static constexpr bool WANTS_REDUCE = false;
+    static constexpr bool WANTS_PROFILE = true;
+
+    ParseProfile profile;
+
+    void begin(const Grammar &g, string_view) {
+        if (profile.ruleApplications.size() < g.rules.size()) profile.ruleApplications.resize(g.rules.size());
+        profile.parses++;
+    }
+    void step(const Grammar &, const vector<int> &stackVec, const Token &) {
+        if (stackVec.size() > profile.maxStackDepth) profile.maxStackDepth = stackVec.size();
+    }
+    void match(const Grammar &, int, const Token &) { profile.matches++; }
+    void apply(const Grammar &, int ruleIdx, const ProdRule &, const Token &) { profile.ruleApplications[ruleIdx]++; }
+    void accept(const Token &, bool) {}
+    void expected(const Grammar &, int, const Token &) { profile.errors++; }
+    void unexpected(const Token &) { profile.errors++; }
+    void skip(const Token &) { profile.recoverySkips++; }
+    void pop(const Grammar &, int, const Token &) { profile.recoveryPops++; }
+    void trailingInput(const Token &) { profile.errors++; }
+};
+
+// Error de sintaxis como dato, para quien llama al parser
+struct Diagnostic {
+    // GRAMMAR: la tabla tiene conflictos y no se parseo; EMPTY: el simbolo
+    // inicial no deriva ninguna cadena y tampoco se parseo (ver BasicParser::parse)
+    enum Kind : uint8_t { EXPECTED, UNEXPECTED, TRAILING, GRAMMAR, EMPTY };
+
+    Kind kind;
+    size_t offset;       // offset del token donde se detecto el error
+    int expected;        // EXPECTED: ID del terminal esperado; GRAMMAR: no terminal
+                         // del primer conflicto; EMPTY: simbolo inicial; -1 en otro caso
+    Token::Type found;   // token encontrado
+};
+
+// Resultado estructurado de parse(), independiente de la politica de traza
+struct ParseResult {
+    bool ok = true;
+    bool aborted = false;              // se alcanzo el limite de errores
+    vector<Diagnostic> diagnostics;    // en orden de aparicion en el input
+};
+
+// Celda de la tabla con mas de una regla que el lookahead no resuelve; se queda la primera
+struct GrammarConflict {
+    int nonTerm;
+    int term;
+    int kept;
+    int rejected;
+};
+
+// Gramatica compilada: la tabla LL(1) y el mapeo de Token::Type a columnas. Las
+// celdas -2 son los conjuntos de sincronizacion por no terminal (FOLLOW menos
+// las entradas de sus reglas) que usa el modo panico. Se construye una vez y despues es inmutable, asi
+// que muchos parsers (tambien en hilos distintos) la comparten sin locks; cada
+// parser solo guarda su stack, su scanner y su traza.
+// Con lookahead > 1 las celdas en conflicto pasan a ser decisiones LL(k): apuntan
+// a un arbol de decision que mira los tokens siguientes. Las celdas sin
+// conflicto no cambian, asi una gramatica LL(1) se parsea igual que antes.
+class CompiledGrammar {
+public:
+    // Las celdas <= LOOKAHEAD_CELL apuntan al nodo de decision LOOKAHEAD_CELL - celda
+    static constexpr int LOOKAHEAD_CELL = -3;
+    static constexpr int MAX_LOOKAHEAD = 4;
+
+private:
+    shared_ptr<const Grammar> source;
+    // Tabla de parseo densa: una fila por no terminal, una columna por terminal.
+    // Cada celda guarda el indice de la regla, -1 (error) o -2 (sincronizacion).
+    vector<ParseCell> parseTable;
+    const ParseCell *table;   // parseTable o la tabla estatica de la gramatica
+    int numTerminals;
+    // ID de terminal para cada Token::Type (-1 si no es terminal de la gramatica)
+    int tokenColumn[Token::END + 1];
+    vector<GrammarConflict> conflictList;
+    // RHS de cada regla en orden inverso, todas seguidas: expandir la regla r es
+    // copiar reversedRhs[rhsStart[r], rhsStart[r + 1]) al tope del stack
+    vector<int> reversedRhs;
+    vector<uint32_t> rhsStart;
+    // Nodos de los arboles de decision LL(k), una fila de numTerminals + 1 celdas
+    // por nodo (la ultima es para los tokens que no son terminales de la
+    // gramatica). Cada celda es una regla u otro nodo; la que no corresponde a
+    // ninguna alternativa tiene la regla que elegiria la tabla LL(1).
+    vector<ParseCell> lookaheadTable;
+    int lookaheadDepth;
+
+    // Secuencias de hasta MAX_LOOKAHEAD terminales en un entero: 14 bits por
+    // terminal y la longitud en los bits altos
+    using TermSeq = uint64_t;
+    static constexpr size_t LOOKAHEAD_SET_LIMIT = 1 << 14;
+
+    static int seqLength(TermSeq s) {
+        return (int) (s >> 56);
+    }
+
+    static int seqAt(TermSeq s, int i) {
+        return (int) (s >> (14 * i)) & 0x3FFF;
+    }
+
+    static TermSeq seqAppend(TermSeq s, int term) {
+        return (s | (TermSeq) term << (14 * seqLength(s))) + ((TermSeq) 1 << 56);
+    }
+
+    // Ya tiene k terminales o termina en $: concatenarle algo no la cambia
+    static bool seqComplete(TermSeq s, int k) {
+        int n = seqLength(s);
+        return n == k || (n > 0 && seqAt(s, n - 1) == END_ID);
+    }
+
+    // Concatenacion de conjuntos truncada a k terminales, ordenada y sin repetidos
+    static vector<TermSeq> concatK(const vector<TermSeq> &x, const vector<TermSeq> &y, int k) {
+        vector<TermSeq> out;
+        for (TermSeq a : x) {
+            if (seqComplete(a, k)) {
+                out.push_back(a);
+                continue;
+            }
+            for (TermSeq b : y) {
+                TermSeq c = a;
+                for (int i = 0; i < seqLength(b) && !seqComplete(c, k); i++) c = seqAppend(c, seqAt(b, i));
+                out.push_back(c);
+            }
+        }
+        sort(out.begin(), out.end());
+        out.erase(unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    // dst |= src; devuelve true si dst crecio
+    static bool mergeInto(vector<TermSeq> &dst, const vector<TermSeq> &src) {
+        vector<TermSeq> merged;
+        merged.reserve(dst.size() + src.size());
+        set_union(dst.begin(), dst.end(), src.begin(), src.end(), back_inserter(merged));
+        if (merged.size() == dst.size()) return false;
+        dst = std::move(merged);
+        return true;
+    }
+
+    // FIRST_k de rhs[from, end)
+    static vector<TermSeq> firstK(const vector<Symbol> &rhs, size_t from, const vector<vector<TermSeq>> &first, int k) {
+        vector<TermSeq> out = {0};
+        for (size_t i = from; i < rhs.size(); i++) {
+            if (rhs[i].type == EPSILON) continue;
+            out = concatK(out, first[rhs[i].id], k);
+        }
+        return out;
+    }
+
+    explicit CompiledGrammar(shared_ptr<const Grammar> g, int lookahead) {
+        source = std::move(g);
+        lookaheadDepth = 1;
+        buildExpansions();
+        buildParseTable();
+        buildLookahead(min(lookahead, MAX_LOOKAHEAD));
+    }
+
+    // Gramatica leida de la cache: la tabla LL(1) ya viene en source->staticTable
+    CompiledGrammar(shared_ptr<const Grammar> g, const GrammarImage &image) {
+        source = std::move(g);
+        lookaheadDepth = image.header.lookaheadDepth;
+        buildExpansions();
+        buildParseTable();
+        lookaheadTable.assign(image.lookahead, image.lookahead + image.header.lookaheadCells);
+        for (int i = 0; i < image.header.numConflicts; i++) {
+            const int32_t *c = image.conflicts + 4 * i;
+            conflictList.push_back({c[0], c[1], c[2], c[3]});
+        }
+    }
+
+    // Celdas de la imagen dentro de rango: reglas existentes, -1, -2 o nodos de
+    // lookahead, y en los nodos solo hijos posteriores, asi predictAhead termina.
+    // Ademas cada regla tiene que ser del no terminal de su celda y predecir su
+    // terminal: una regla equivocada puede expandir sin consumir input para
+    // siempre (con (F, ID) -> ( E ), E -> T E' y T -> F T' el stack crece sin fin).
+    static bool validCells(const GrammarImage &image) {
+        const GrammarImage::Header &h = image.header;
+        size_t width = (size_t) h.numTerminals + 1;
+        if (h.lookaheadCells % width != 0 || h.lookaheadDepth < 1 || h.lookaheadDepth > MAX_LOOKAHEAD) return false;
+        long nodes = (long) (h.lookaheadCells / width);
+        auto valid = [&](ParseCell cell, long minNode) {
+            if (cell >= 0) return cell < h.numRules;
+            if (cell >= -2) return true;
+            long node = LOOKAHEAD_CELL - cell;
+            return node >= minNode && node < nodes;
+        };
+        size_t cells = (size_t) (h.numSymbols - h.numTerminals) * h.numTerminals;
+        for (size_t i = 0; i < cells; i++) {
+            if (!valid(image.table[i], 0)) return false;
+        }
+        for (size_t i = 0; i < (size_t) h.lookaheadCells; i++) {
+            if (!valid(image.lookahead[i], (long) (i / width) + 1)) return false;
+        }
+
+        // FIRST de cada RHS y si es anulable, con los conjuntos de la imagen
+        size_t words = GrammarImage::setWords(h.numTerminals);
+        vector<uint64_t> firstRhs((size_t) h.numRules * words, 0);
+        vector<char> nullableRhs(h.numRules, true);
+        for (int r = 0; r < h.numRules; r++) {
+            uint64_t *set = &firstRhs[(size_t) r * words];
+            for (uint32_t i = image.rhsStart[r]; i < image.rhsStart[r + 1] && nullableRhs[r]; i++) {
+                int id = image.rhsIds[i];
+                if (image.rhsTypes[i] == EPSILON) continue;
+                if (image.rhsTypes[i] == NON_TERMINAL) {
+                    for (size_t w = 0; w < words; w++) set[w] |= image.first[(size_t) id * words + w];
+                    nullableRhs[r] = image.nullable[id];
+                } else {
+                    set[id / 64] |= 1ull << (id % 64);
+                    nullableRhs[r] = false;
+                }
+            }
+        }
+        auto predicts = [&](int rule, int nonTerm, int term) {
+            auto has = [term](const uint64_t *set) { return (set[term / 64] >> (term % 64)) & 1; };
+            return image.lhs[rule] == nonTerm && (has(&firstRhs[(size_t) rule * words]) ||
+                                                  (nullableRhs[rule] && has(image.follow + (size_t) nonTerm * words)));
+        };
+
+        // Los nodos de lookahead forman un arbol por celda: cada nodo hereda la
+        // celda (no terminal, terminal) que lo usa y sus reglas se validan contra ella
+        vector<long> owner(nodes, -1);
+        auto visit = [&](ParseCell cell, long ownerCell) {
+            int nonTerm = h.numTerminals + (int) (ownerCell / h.numTerminals), term = (int) (ownerCell % h.numTerminals);
+            if (cell >= 0) return predicts(cell, nonTerm, term);
+            if (cell > LOOKAHEAD_CELL) return true;
+            long &o = owner[LOOKAHEAD_CELL - cell];
+            if (o >= 0 && o != ownerCell) return false;
+            o = ownerCell;
+            return true;
+        };
+        for (size_t i = 0; i < cells; i++) {
+            if (!visit(image.table[i], (long) i)) return false;
+        }
+        for (long node = 0; node < nodes; node++) {
+            if (owner[node] < 0) return false;
+            for (size_t t = 0; t < width; t++) {
+                if (!visit(image.lookahead[node * width + t], owner[node])) return false;
+            }
+        }
+        for (int i = 0; i < h.numConflicts; i++) {
+            const int32_t *c = image.conflicts + 4 * i;
+            if (c[0] < h.numTerminals || c[0] >= h.numSymbols || c[1] < 0 || c[1] >= h.numTerminals
+                || c[2] < 0 || c[2] >= h.numRules || c[3] < 0 || c[3] >= h.numRules) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void buildExpansions() {
+        const vector<ProdRule> &rules = source->grammarRules();
+        rhsStart.assign(1, 0);
+        for (const ProdRule &rule : rules) {
+            if (rule.rhs[0].type != EPSILON) {
+                for (auto it = rule.rhs.rbegin(); it != rule.rhs.rend(); ++it) reversedRhs.push_back(it->id);
+            }
+            rhsStart.push_back((uint32_t) reversedRhs.size());
+        }
+    }
+
+    // Funcion que construye la tabla de parseo
+    void buildParseTable() {
+        numTerminals = source->numTerminals;
+
+        // El token END corresponde al terminal $ (ID 0)
+        for (int t = 0; t <= Token::END; t++) {
+            tokenColumn[t] = t == Token::END ? END_ID : source->symbolId(Token(static_cast<Token::Type>(t)).toString());
+            if (tokenColumn[t] >= numTerminals) tokenColumn[t] = -1;
+        }
+
+        // Gramatica constexpr: la tabla ya se construyo (y verifico) al compilar
+        if (source->staticTable) {
+            table = source->staticTable;
+            return;
+        }
+
+        // Inicializamos la tabla de parseo con valores -1
+        parseTable.assign((size_t) source->nonTerminalCount() * numTerminals, -1);
+
+        // Para cada regla de produccion, procesamos la RHS. El indice de la regla es
+        // el del recorrido, asi el costo total es O(reglas * |RHS| + celdas).
+        const vector<ProdRule> &rules = source->grammarRules();
+        for (int ruleIndex = 0; ruleIndex < (int) rules.size(); ruleIndex++) {
+            const ProdRule &rule = rules[ruleIndex];
+            // Las entradas de la regla son FIRST(RHS) y, si la RHS es nullable, FOLLOW(LHS)
+            bool nullable;
+            TermSet predictSet = source->calcFirst(rule.rhs, nullable);
+            if (nullable) predictSet.unionWith(source->FOLLOW[rule.lhsId]);
+
+            // Insertamos las reglas en la tabla de parseo
+            ParseCell *row = &parseTable[(size_t) (rule.lhsId - numTerminals) * numTerminals];
+            predictSet.forEach([&](int term) {
+                // Gramatica no es LL1: se registra el conflicto en lugar de abortar
+                if (row[term] != -1) {
+                    conflictList.push_back({rule.lhsId, term, row[term], ruleIndex});
+                    return;
+                }
+                row[term] = ruleIndex;
+            });
+        }
+
+        // Revisamos si hay sincronización
+        for (int nonTerm = numTerminals; nonTerm < source->symbolCount(); nonTerm++) {
+            // Recorremos el conjunto FOLLOW
+            ParseCell *row = &parseTable[(size_t) (nonTerm - numTerminals) * numTerminals];
+            source->FOLLOW[nonTerm].forEach([&](int term) {
+                if (row[term] == -1) row[term] = -2;
+            });
+        }
+        table = parseTable.data();
+
+    }
+
+    // Resuelve las celdas en conflicto con hasta k tokens de lookahead (LL(k)
+    // fuerte): las entradas de la regla A -> w son FIRST_k(w) . FOLLOW_k(A). Los
+    // conjuntos se calculan como punto fijo sobre toda la gramatica, asi que
+    // solo se paga cuando hay conflictos; si alguno pasa de LOOKAHEAD_SET_LIMIT
+    // secuencias la tabla queda como LL(1).
+    void buildLookahead(int k) {
+        if (k < 2 || conflictList.empty() || numTerminals >= (1 << 14)) return;
+        const vector<ProdRule> &rules = source->grammarRules();
+
+        vector<vector<TermSeq>> first(source->symbolCount());
+        for (int t = 0; t < numTerminals; t++) first[t] = {seqAppend(0, t)};
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (const ProdRule &rule : rules) {
+                changed = mergeInto(first[rule.lhsId], firstK(rule.rhs, 0, first, k)) || changed;
+                if (first[rule.lhsId].size() > LOOKAHEAD_SET_LIMIT) return;
+            }
+        }
+
+        vector<vector<TermSeq>> follow(source->symbolCount());
+        follow[source->startSymbol()] = {seqAppend(0, END_ID)};
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (const ProdRule &rule : rules) {
+                for (size_t i = 0; i < rule.rhs.size(); i++) {
+                    if (rule.rhs[i].type != NON_TERMINAL) continue;
+                    vector<TermSeq> rest = concatK(firstK(rule.rhs, i + 1, first, k), follow[rule.lhsId], k);
+                    changed = mergeInto(follow[rule.rhs[i].id], rest) || changed;
+                    if (follow[rule.rhs[i].id].size() > LOOKAHEAD_SET_LIMIT) return;
+                }
+            }
+        }
+
+        // Una decision por celda en conflicto; las que quedan ambiguas con k
+        // tokens siguen en conflictList
+        vector<GrammarConflict> cells = conflictList;
+        sort(cells.begin(), cells.end(), [](const GrammarConflict &a, const GrammarConflict &b) {
+            return a.nonTerm != b.nonTerm ? a.nonTerm < b.nonTerm : a.term < b.term;
+        });
+        set<pair<int, int>> ambiguousCells;
+        vector<pair<TermSeq, int>> entries;   // (secuencia, regla) del no terminal actual
+        for (size_t i = 0; i < cells.size(); i++) {
+            int nonTerm = cells[i].nonTerm, term = cells[i].term;
+            if (i > 0 && nonTerm == cells[i - 1].nonTerm && term == cells[i - 1].term) continue;
+            if (i == 0 || nonTerm != cells[i - 1].nonTerm) {
+                entries.clear();
+                for (int r : source->rulesFor(nonTerm)) {
+                    for (TermSeq s : concatK(firstK(rules[r].rhs, 0, first, k), follow[nonTerm], k)) entries.push_back({s, r});
+                }
+            }
+            vector<pair<TermSeq, int>> items;
+            for (const auto &entry : entries) {
+                if (seqAt(entry.first, 0) == term) items.push_back(entry);
+            }
+            ParseCell &cell = parseTable[(size_t) (nonTerm - numTerminals) * numTerminals + term];
+            bool ambiguous = false;
+            cell = decide(items, 1, k, cell, ambiguous);
+            if (ambiguous) ambiguousCells.insert({nonTerm, term});
+        }
+        conflictList.erase(remove_if(conflictList.begin(), conflictList.end(), [&](const GrammarConflict &c) {
+            return !ambiguousCells.count({c.nonTerm, c.term});
+        }), conflictList.end());
+    }
+
+    // Arma el nodo que distingue items (secuencias con el mismo prefijo de pos
+    // terminales) por el terminal en pos. Devuelve la celda: una regla o un nodo.
+    // Los terminales que no continuan ninguna secuencia quedan en -1: el input no
+    // puede ser valido y la recuperacion descarta el token, en vez de expandir
+    // una regla que no lo predice (con handleError eso no avanza nunca).
+    int decide(vector<pair<TermSeq, int>> &items, int pos, int k, int fallback, bool &ambiguous) {
+        // Sin secuencias (el no terminal no es alcanzable, FOLLOW_k vacio) no hay
+        // con que decidir: la celda queda como en LL(1) y sigue en conflicto
+        if (items.empty()) {
+            ambiguous = true;
+            return fallback;
+        }
+        int firstRule = INT32_MAX, lastRule = -1;
+        for (const auto &item : items) {
+            firstRule = min(firstRule, item.second);
+            lastRule = max(lastRule, item.second);
+        }
+        if (firstRule == lastRule) return firstRule;
+        // Secuencias iguales de reglas distintas: no alcanzan k tokens (o ya se llego a $)
+        if (pos == k || seqLength(items[0].first) == pos) {
+            ambiguous = true;
+            return firstRule;
+        }
+
+        size_t width = (size_t) numTerminals + 1;
+        size_t node = lookaheadTable.size() / width;
+        lookaheadTable.resize(lookaheadTable.size() + width, -1);
+        lookaheadDepth = max(lookaheadDepth, pos + 1);
+        sort(items.begin(), items.end(), [pos](const pair<TermSeq, int> &a, const pair<TermSeq, int> &b) {
+            return seqAt(a.first, pos) < seqAt(b.first, pos);
+        });
+        for (size_t i = 0; i < items.size();) {
+            int term = seqAt(items[i].first, pos);
+            size_t j = i;
+            while (j < items.size() && seqAt(items[j].first, pos) == term) j++;
+            vector<pair<TermSeq, int>> group(items.begin() + i, items.begin() + j);
+            int cell = decide(group, pos + 1, k, fallback, ambiguous);
+            lookaheadTable[node * width + term] = cell;
+            i = j;
+        }
+        return LOOKAHEAD_CELL - (int) node;
+    }
+
+public:
+    CompiledGrammar(const CompiledGrammar &) = delete;
+    CompiledGrammar &operator=(const CompiledGrammar &) = delete;
+
+    // lookahead es la cantidad maxima de tokens (hasta MAX_LOOKAHEAD) con que se
+    // intenta resolver los conflictos de la tabla LL(1)
+    static shared_ptr<const CompiledGrammar> compile(shared_ptr<const Grammar> g, int lookahead = 1) {
+        return shared_ptr<const CompiledGrammar>(new CompiledGrammar(std::move(g), lookahead));
+    }
+
+    static shared_ptr<const CompiledGrammar> compile(Grammar g, int lookahead = 1) {
+        return compile(make_shared<const Grammar>(std::move(g)), lookahead);
+    }
+
+    // Clave de la cache en disco: las reglas tal como se escribieron (antes de
+    // GrammarTransform) y el lookahead pedido
+    static uint64_t cacheKey(const vector<ProdRule> &rules, int lookahead = 1) {
+        return (Grammar::fingerprint(rules) ^ (uint64_t) lookahead) * 1099511628211ull;
+    }
+
+    // Escribe la gramatica compilada en path con el formato de GrammarImage. Se
+    // escribe en un archivo temporal que despues se renombra, asi otro proceso
+    // que abre path ve el archivo anterior o el nuevo completo, nunca uno a medias.
+    bool save(const string &path, uint64_t key) const {
+        const Grammar &g = *source;
+        int S = g.symbolCount(), T = numTerminals, R = (int) g.rules.size();
+        string out(sizeof(GrammarImage::Header), '\0');
+        auto put = [&out](const void *data, size_t bytes) {
+            out.append(static_cast<const char *>(data), bytes);
+            out.resize((out.size() + 7) & ~(size_t) 7, '\0');
+        };
+
+        vector<uint32_t> nameOffsets = {0};
+        string names;
+        for (int id = 0; id < S; id++) {
+            names += g.name(id);
+            nameOffsets.push_back((uint32_t) names.size());
+        }
+        vector<uint32_t> rhsBegin = {0};
+        vector<int32_t> lhs, rhsIds;
+        vector<uint8_t> rhsTypes;
+        for (const ProdRule &rule : g.rules) {
+            lhs.push_back(rule.lhsId);
+            for (const Symbol &symbol : rule.rhs) {
+                rhsIds.push_back(symbol.id);
+                rhsTypes.push_back((uint8_t) symbol.type);
+            }
+            rhsBegin.push_back((uint32_t) rhsIds.size());
+        }
+        vector<uint64_t> first, follow;
+        for (int id = 0; id < S; id++) {
+            first.insert(first.end(), g.FIRST[id].words.begin(), g.FIRST[id].words.end());
+            follow.insert(follow.end(), g.FOLLOW[id].words.begin(), g.FOLLOW[id].words.end());
+        }
+        vector<int32_t> conflicts;
+        for (const GrammarConflict &c : conflictList) conflicts.insert(conflicts.end(), {c.nonTerm, c.term, c.kept, c.rejected});
+
+        put(nameOffsets.data(), nameOffsets.size() * sizeof(uint32_t));
+        put(names.data(), names.size());
+        put(rhsBegin.data(), rhsBegin.size() * sizeof(uint32_t));
+        put(lhs.data(), lhs.size() * sizeof(int32_t));
+        put(rhsIds.data(), rhsIds.size() * sizeof(int32_t));
+        put(rhsTypes.data(), rhsTypes.size());
+        put(g.NULLABLE.data(), g.NULLABLE.size());
+        put(first.data(), first.size() * sizeof(uint64_t));
+        put(follow.data(), follow.size() * sizeof(uint64_t));
+        put(table, (size_t) (S - T) * T * sizeof(ParseCell));
+        put(lookaheadTable.data(), lookaheadTable.size() * sizeof(ParseCell));
+        put(conflicts.data(), conflicts.size() * sizeof(int32_t));
+
+        GrammarImage::Header h{};
+        GrammarImage::magic(h.magic);
+        h.byteOrder = GrammarImage::ENDIAN_MARK;
+        h.version = GrammarImage::VERSION;
+        h.key = key;
+        h.fileSize = out.size();
+        h.numTerminals = T;
+        h.numSymbols = S;
+        h.numRules = R;
+        h.rhsLength = (int32_t) rhsIds.size();
+        h.nameBytes = (int32_t) names.size();
+        h.lookaheadDepth = lookaheadDepth;
+        h.lookaheadCells = (int32_t) lookaheadTable.size();
+        h.numConflicts = (int32_t) conflictList.size();
+        h.checksum = GrammarImage::checksum(h, string_view(out).substr(sizeof(h)));
+        memcpy(&out[0], &h, sizeof(h));
+
+        string tmp = path + ".tmp" + to_string(getpid());
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        size_t written = 0;
+        while (written < out.size()) {
+            ssize_t n = ::write(fd, out.data() + written, out.size() - written);
+            if (n <= 0) break;
+            written += (size_t) n;
+        }
+        bool ok = ::close(fd) == 0 && written == out.size() && rename(tmp.c_str(), path.c_str()) == 0;
+        if (!ok) unlink(tmp.c_str());
+        return ok;
+    }
+
+    // Mapea una gramatica guardada con save(). Devuelve nullptr si el archivo no
+    // existe, es de otra version o clave, o no pasa la validacion.
+    static shared_ptr<const CompiledGrammar> load(const string &path, uint64_t key) {
+        auto file = make_shared<MappedFile>();
+        GrammarImage image;
+        if (!file->open(path.c_str()) || !image.read(file->view(), key) || !validCells(image)) return nullptr;
+        auto g = make_shared<const Grammar>(image, std::move(file));
+        return shared_ptr<const CompiledGrammar>(new CompiledGrammar(std::move(g), image));
+    }
+
+    // Compila rules pasando por la cache en disco de dir. El archivo se nombra con
+    // la clave, asi varias gramaticas comparten el directorio; si no esta o no
+    // valida se compila y se escribe (si no se puede escribir, solo se compila).
+    static shared_ptr<const CompiledGrammar> compileCached(const vector<ProdRule> &rules, const string &dir,
+                                                           int lookahead = 1) {
+        uint64_t key = cacheKey(rules, lookahead);
+        char name[48];
+        snprintf(name, sizeof(name), "/gramatica-%016llx.ll1", (unsigned long long) key);
+        string path = dir + name;
+        if (shared_ptr<const CompiledGrammar> cached = load(path, key)) return cached;
+        shared_ptr<const CompiledGrammar> compiled = compile(Grammar(rules), lookahead);
+        compiled->save(path, key);
+        return compiled;
+    }
+
+    const Grammar &grammar() const {
+        return *source;
+    }
+
+    int terminalIndex(Token::Type type) const {
+        return tokenColumn[type];
+    }
+
+    // Entrada de la tabla para (no terminal, terminal); solo una lectura del arreglo
+    int predict(int nonTerm, int term) const {
+        return table[(size_t) (nonTerm - numTerminals) * numTerminals + term];
+    }
+
+    // Paso de una decision LL(k): cell es un nodo y term el terminal del token a
+    // la profundidad del nodo (o -1); devuelve una regla u otro nodo
+    int predictAhead(int cell, int term) const {
+        size_t width = (size_t) numTerminals + 1;
+        return lookaheadTable[(size_t) (LOOKAHEAD_CELL - cell) * width + (term < 0 ? numTerminals : term)];
+    }
+
+    // Tokens que mira la decision mas profunda; 1 si la tabla es LL(1)
+    int lookahead() const {
+        return lookaheadDepth;
+    }
+
+    // Simbolos de la RHS de la regla, del ultimo al primero; epsilon no tiene ninguno
+    const int *expansion(int ruleIdx) const {
+        return reversedRhs.data() + rhsStart[ruleIdx];
+    }
+
+    int expansionLength(int ruleIdx) const {
+        return (int) (rhsStart[ruleIdx + 1] - rhsStart[ruleIdx]);
+    }
+
+    // Vacio si la gramatica es LL(k) para el lookahead con que se compilo
+    const vector<GrammarConflict> &conflicts() const {
+        return conflictList;
+    }
+};
+
+template <class Trace>
+class BasicParser {
+private:
+    shared_ptr<const CompiledGrammar> language;
+    const Grammar *grammar;
+    Scanner *scanner;
+    TokenStream tokens;
+    bool threadedLexing;
+    Token currentToken;
+    Trace trace;
+    ParseResult result;
+    size_t errorLimit;
+    // true desde un error hasta el proximo match: los errores en cascada no se reportan
+    bool recovering;
+    // Token y altura del stack del ultimo terminal dado por faltante (ver handleError)
+    size_t missingOffset;
+    size_t missingDepth;
+    // Arbol que se construye durante parse(), o nullptr si solo se valida
+    ParseTree *tree;
+    vector<uint32_t> nodeStack;
+    // Stack de simbolos (el tope al final); se vacia en cada parse() pero
+    // conserva su capacidad
+    vector<int> parseStack;
+
+public:
+
+    // Constructor: comparte la gramatica compilada, no construye nada
+    BasicParser(Scanner *s, shared_ptr<const CompiledGrammar> compiled) : tokens(s), currentToken(Token::END) {
+        this->threadedLexing = false;
+        this->tree = nullptr;
+        this->errorLimit = SIZE_MAX;
+        this->recovering = false;
+        this->scanner = s;
+        this->language = std::move(compiled);
+        this->grammar = &language->grammar();
+        parseStack.reserve(256);
+    }
+
+    // Compila la tabla solo para este parser; g debe vivir mas que el parser
+    BasicParser(Scanner *s, const Grammar *g)
+        : BasicParser(s, CompiledGrammar::compile(shared_ptr<const Grammar>(g, [](const Grammar *) {}))) {}
+
+    Trace &tracer() {
+        return trace;
+    }
+
+    // Resultado y errores del ultimo parse()
+    const ParseResult &lastResult() const {
+        return result;
+    }
+
+    // parse() se detiene despues de limit errores reportados
+    void setErrorLimit(size_t limit) {
+        errorLimit = limit ? limit : 1;
+    }
+
+    // Apunta el parser a otro scanner sin reconstruir la tabla; los stacks y
+    // buffers del parser se reusan en el proximo parse()
+    void setScanner(Scanner *s) {
+        scanner = s;
+        tokens.setScanner(s);
+    }
+
+    // Si es true, parse() corre el scanner en un hilo productor
+    void setThreadedLexing(bool enabled) {
+        threadedLexing = enabled;
+    }
+
+    int terminalIndex(Token::Type type) const {
+        return language->terminalIndex(type);
+    }
+
+    int predict(int nonTerm, int term) const {
+        return language->predict(nonTerm, term);
+    }
+
+    // Modulo para realizar el match
+    void match(int top) {
+        trace.match(*grammar, top, currentToken);
+        if (tree) {
+            ParseNode &leaf = tree->node(nodeStack.back());
+            leaf.offset = currentToken.offset;
+            leaf.length = (uint32_t) currentToken.lexeme.size();
+            nodeStack.pop_back();
+        }
+        currentToken = tokens.next();  // Obtenemos el siguiente token
+        recovering = false;
+    }
+
+    // Registra un error; devuelve false si se agoto el presupuesto de errores
+    bool report(Diagnostic::Kind kind, int expected) {
+        result.ok = false;
+        recovering = true;
+        result.diagnostics.push_back({kind, currentToken.offset, expected, currentToken.type});
+        if (result.diagnostics.size() >= errorLimit) result.aborted = true;
+        return !result.aborted;
+    }
+
+    // Funcion principal de parseo. Si out no es nullptr se construye ahi el
+    // arbol de parseo (se libera su contenido anterior). start permite parsear
+    // desde otro no terminal; por defecto es el simbolo inicial de la gramatica.
+    // Devuelve true si no hubo errores de sintaxis; el detalle queda en lastResult().
+    // Cada iteracion consume un token, saca un simbolo o expande una regla, asi que
+    // con una tabla sin conflictos el tiempo es lineal tambien con input arbitrario.
+    bool parse(ParseTree *out = nullptr, int start = -1) {
+        if (start < 0) start = grammar->startSymbol();
+        tree = out;
+        result.ok = true;
+        result.aborted = false;
+        result.diagnostics.clear();
+        // Con conflictos la tabla se queda con una regla cualquiera por celda y
+        // puede expandir sin consumir input para siempre (una recursion por
+        // izquierda detras de un prefijo anulable): no se parsea
+        if (!language->conflicts().empty()) {
+            result.ok = false;
+            result.diagnostics.push_back({Diagnostic::GRAMMAR, 0, language->conflicts()[0].nonTerm, Token::END});
+            return false;
+        }
+        // Sin ninguna cadena que aceptar todo input es un error
+        if (!grammar->productive(start)) {
+            result.ok = false;
+            result.diagnostics.push_back({Diagnostic::EMPTY, 0, start, Token::END});
+            return false;
+        }
+        recovering = false;
+        missingOffset = SIZE_MAX;
+        nodeStack.clear();
+        if (tree) {
+            nodeStack.push_back(ParseTree::NONE);
+            nodeStack.push_back(tree->makeRoot(start));
+        }
+        trace.begin(*grammar, scanner->getInput());
+        chrono::steady_clock::time_point startTime;
+        if constexpr (Trace::WANTS_PROFILE) {
+            startTime = chrono::steady_clock::now();
+            scanner->setProfile(&trace.profile.scan);
+        }
+        tokens.start(threadedLexing);
+        currentToken = tokens.next();  // Obtenemos el primer token
+        parseStack.clear();
+
+        // Inicializamos el stack con el simbolo inicial y $
+        parseStack.push_back(END_ID);
+        parseStack.push_back(start);
+
+        // Ciclo principal del parseo
+        while (!parseStack.empty() && !result.aborted) {
+            int top = parseStack.back();
+            int tokenId = language->terminalIndex(currentToken.type);
+
+            // Marcador de fin de regla: toda la RHS ya fue reconocida
+            if constexpr (Trace::WANTS_REDUCE) {
+                if (top <= REDUCE_MARKER) {
+                    parseStack.pop_back();
+                    trace.reduce(*grammar, REDUCE_MARKER - top, currentToken);
+                    continue;
+                }
+            }
+
+            trace.step(*grammar, parseStack, currentToken);
+
+            if (top == END_ID) {
+                // Si llegamos al final del stack y aun hay tokens, hay un error
+                if (currentToken.type != Token::END) {
+                    trace.trailingInput(currentToken);
+                    report(Diagnostic::TRAILING, -1);
+                    break;
+                }
+                trace.accept(currentToken, result.ok);
+                tokens.stop();
+                finishProfile(startTime);
+                return result.ok;
+            }
+
+            // Si el tope del stack es terminal
+            if (grammar->isTerminal(top)) {
+                if (top == tokenId) {
+                    match(top);  // Llamamos a la funcion modularizada
+                    parseStack.pop_back();
+                } else {
+                    handleError(top);
+                }
+            } else {
+                applyRule(top, tokenId);
+            }
+        }
+        tokens.stop();
+        finishProfile(startTime);
+        result.ok = false;
+        return false;
+    }
+
+    // Desconecta el scanner del perfil y suma la duracion del parse()
+    void finishProfile(chrono::steady_clock::time_point startTime) {
+        if constexpr (Trace::WANTS_PROFILE) {
+            scanner->setProfile(nullptr);
+            trace.profile.totalNanos +=
+                chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - startTime).count();
+        } else {
+            (void) startTime;
+        }
+    }
+
+    // Funcion para manejar errores de sintaxis: el terminal esperado se da por
+    // faltante y se saca del stack sin consumir input. Si en el mismo token ya se
+    // saco otro con el stack igual de bajo, las expansiones lo volvieron a armar
+    // (con LL(k) fuerte una celda puede predecir por lo que sigue en otro
+    // contexto) y sacarlo de nuevo no termina: se descarta el token, o con el
+    // fin de input se abandona el resto del stack.
+    void handleError(int top) {
+        if (!recovering) {
+            trace.expected(*grammar, top, currentToken);
+            report(Diagnostic::EXPECTED, top);
+        }
+        if (currentToken.offset == missingOffset && parseStack.size() >= missingDepth) {
+            if (currentToken.type != Token::END) {
+                trace.skip(currentToken);
+                currentToken = tokens.next();
+                return;
+            }
+            parseStack.resize(1);
+            while (tree && nodeStack.size() > 1) popMissingNode();
+            return;
+        }
+        missingOffset = currentToken.offset;
+        missingDepth = parseStack.size();
+        parseStack.pop_back();
+        popMissingNode();
+    }
+
+    // El simbolo se saco del stack sin reconocerse
+    void popMissingNode() {
+        if (!tree) return;
+        tree->node(nodeStack.back()).flags |= ParseNode::MISSING;
+        nodeStack.pop_back();
+    }
+
+    // Celda de una decision LL(k): se recorre su arbol con los tokens que siguen
+    // al actual, sin consumirlos
+    int predictAhead(int cell) {
+        for (size_t i = 0; cell <= CompiledGrammar::LOOKAHEAD_CELL; i++) {
+            cell = language->predictAhead(cell, language->terminalIndex(tokens.peek(i).type));
+        }
+        return cell;
+    }
+
+    // Funcion que aplica la regla correspondiente
+    void applyRule(int top, int tokenId) {
+        int ruleIdx = tokenId < 0 ? -1 : predict(top, tokenId);
+        if (ruleIdx <= CompiledGrammar::LOOKAHEAD_CELL) ruleIdx = predictAhead(ruleIdx);
+        if (ruleIdx < 0) {
+            // Modo panico: un solo error por corrida de tokens descartados
+            if (!recovering) {
+                trace.unexpected(currentToken);
+                if (!report(Diagnostic::UNEXPECTED, -1)) return;
+            }
+            // Se descartan tokens hasta uno que top puede empezar (FIRST) o que
+            // puede seguirlo (celda -2, FOLLOW)
+            while (ruleIdx == -1 && currentToken.type != Token::END) {
+                trace.skip(currentToken);
+                currentToken = tokens.next();
+                tokenId = language->terminalIndex(currentToken.type);
+                ruleIdx = tokenId < 0 ? -1 : predict(top, tokenId);
+            }
+            // El ciclo principal aplica la regla (o resuelve la decision LL(k))
+            if (ruleIdx >= 0 || ruleIdx <= CompiledGrammar::LOOKAHEAD_CELL) return;
+            trace.pop(*grammar, top, currentToken);
+            parseStack.pop_back();
+            popMissingNode();
+        } else {
+            // La RHS invertida ya esta armada en la gramatica compilada: se copia entera
+            parseStack.pop_back();
+            if constexpr (Trace::WANTS_REDUCE) parseStack.push_back(REDUCE_MARKER - ruleIdx);
+            const int *symbols = language->expansion(ruleIdx);
+            parseStack.insert(parseStack.end(), symbols, symbols + language->expansionLength(ruleIdx));
+            if (tree) expandNode(ruleIdx);
+            trace.apply(*grammar, ruleIdx, grammar->rules[ruleIdx], currentToken);
+        }
+    }
+
+    // Crea los hijos del nodo en el tope con el mismo orden que el stack de simbolos
+    void expandNode(int ruleIdx) {
+        uint32_t parentIdx = nodeStack.back();
+        nodeStack.pop_back();
+        const int *symbols = language->expansion(ruleIdx);
+        uint32_t count = (uint32_t) language->expansionLength(ruleIdx);
+        uint32_t first = count ? tree->allocate(count) : ParseTree::NONE;
+        ParseNode &parent = tree->node(parentIdx);
+        parent.rule = ruleIdx;
+        parent.firstChild = first;
+        parent.childCount = count;
+        // symbols va del ultimo hijo al primero, igual que el stack de simbolos
+        for (uint32_t k = 0; k < count; k++) {
+            tree->initNode(first + count - 1 - k, symbols[k]);
+            nodeStack.push_back(first + count - 1 - k);
+        }
+    }
+};
+
+using Parser = BasicParser<VerboseTrace>;
+using QuietParser = BasicParser<QuietTrace>;
+using ProfilingParser = BasicParser<ProfileTrace>;
+
+// Pool de parsers para procesos que parsean muchos inputs: acquire() entrega un
+// parser ya construido (con sus stacks y buffers) y el Lease lo devuelve al pool
+// al destruirse, asi la memoria queda acotada por la cantidad de parsers en uso.
+template <class Trace>
+class BasicParserPool {
+    public:
+        using ParserType = BasicParser<Trace>;
+
+        class Lease {
+            private:
+                BasicParserPool *pool;
+                unique_ptr<ParserType> parser;
+
+            public:
+                Lease(BasicParserPool *p, unique_ptr<ParserType> owned) : pool(p), parser(std::move(owned)) {}
+                Lease(Lease &&) = default;
+                Lease &operator=(Lease &&other) {
+                    if (this != &other) {
+                        release();
+                        pool = other.pool;
+                        parser = std::move(other.parser);
+                    }
+                    return *this;
+                }
+                Lease(const Lease &) = delete;
+                Lease &operator=(const Lease &) = delete;
+
+                ParserType &operator*() const { return *parser; }
+                ParserType *operator->() const { return parser.get(); }
+
+                void release() {
+                    if (parser) pool->giveBack(std::move(parser));
+                }
+
+                ~Lease() {
+                    release();
+                }
+        };
+
+    private:
+        shared_ptr<const CompiledGrammar> language;
+        size_t maxIdle;
+        mutex m;
+        vector<unique_ptr<ParserType>> idle;
+
+        void giveBack(unique_ptr<ParserType> parser) {
+            parser->setScanner(nullptr);
+            lock_guard<mutex> lock(m);
+            if (idle.size() < maxIdle) idle.push_back(std::move(parser));
+        }
+
+    public:
+        // maxIdle acota los parsers que se guardan; los que sobran se destruyen al devolverse
+        explicit BasicParserPool(shared_ptr<const CompiledGrammar> compiled, size_t maxIdleParsers = 64)
+            : language(std::move(compiled)), maxIdle(maxIdleParsers) {}
+
+        BasicParserPool(const BasicParserPool &) = delete;
+        BasicParserPool &operator=(const BasicParserPool &) = delete;
+
+        // El parser queda apuntando a s; el pool debe vivir mas que el Lease
+        Lease acquire(Scanner *s) {
+            unique_ptr<ParserType> parser;
+            {
+                lock_guard<mutex> lock(m);
+                if (!idle.empty()) {
+                    parser = std::move(idle.back());
+                    idle.pop_back();
+                }
+            }
+            if (!parser) parser.reset(new ParserType(s, language));
+            else parser->setScanner(s);
+            return Lease(this, std::move(parser));
+        }
+
+        size_t idleCount() {
+            lock_guard<mutex> lock(m);
+            return idle.size();
+        }
+};
 
+using ParserPool = BasicParserPool<QuietTrace>;
@@ -0,0 +1,206 @@
+#include <fstream>
+#include <sstream>
+#include "classes.cpp"
+#include "grammar_rules.cpp"
+
+using namespace std;
+
+// Generador de parsers: toma la gramatica de generateGrammarRules() y emite un
+// parser descendente recursivo especializado, con un switch sobre Token::Type por
+// no terminal, sin tabla en tiempo de ejecucion ni comparaciones de strings.
+// Las reglas que terminan en su propio LHS (SL', E', T') se emiten como ciclos,
+// asi la recursion solo crece con el anidamiento de parentesis. Esa recursion se
+// corta a MAX_DEPTH llamadas anidadas: parse() devuelve false con depthExceeded()
+// y quien llama puede volver a parsear con el parser de tabla, que no usa el stack.
+//
+// Uso: ./codegen [archivo]   (por defecto escribe en stdout)
+
+static const char *tokenTypeName(Token::Type type) {
+    switch (type) {
+        case Token::ID: return "Token::ID";
+        case Token::NUM: return "Token::NUM";
+        case Token::ASSIGN: return "Token::ASSIGN";
+        case Token::SEMI: return "Token::SEMI";
+        case Token::LP: return "Token::LP";
+        case Token::RP: return "Token::RP";
+        case Token::PLUS: return "Token::PLUS";
+        case Token::MIN: return "Token::MIN";
+        case Token::MUL: return "Token::MUL";
+        case Token::ERR: return "Token::ERR";
+        case Token::PRINT: return "Token::PRINT";
+        case Token::END: return "Token::END";
+        default: return "Token::ERR";
+    }
+}
+
+// Nombre de funcion valido en C++ para un no terminal: SL' -> parse_SL_p
+static string functionName(const Grammar &g, int nonTerm) {
+    string name = "parse_";
+    for (char c : g.name(nonTerm)) {
+        if (isalnum((unsigned char) c)) name += c;
+        else if (c == '\'') name += "_p";
+        else name += '_';
+    }
+    return name + "_" + to_string(nonTerm);
+}
+
+static void emitRuleBody(ostream &out, const Grammar &g, int ruleIdx, const vector<int> &tokenOfTerminal,
+                         bool firstChecked) {
+    const ProdRule &rule = g.rules[ruleIdx];
+    const string indent = "                ";
+    out << indent << "// " << rule.lhs << " ->";
+    for (const Symbol &sym : rule.rhs) out << " " << sym.value;
+    out << "\n";
+
+    for (size_t i = 0; i < rule.rhs.size(); i++) {
+        const Symbol &sym = rule.rhs[i];
+        if (sym.type == EPSILON) continue;
+        if (sym.type == TERMINAL) {
+            int type = tokenOfTerminal[sym.id];
+            if (type < 0) {
+                out << indent << "return fail();\n";
+                return;
+            }
+            if (!(i == 0 && firstChecked)) {
+                out << indent << "if (cur.type != " << tokenTypeName((Token::Type) type) << ") return fail();\n";
+            }
+            out << indent << "advance();\n";
+        } else if (i + 1 == rule.rhs.size() && sym.id == rule.lhsId) {
+            out << indent << "continue;\n";
+            return;
+        } else {
+            out << indent << "if (!" << functionName(g, sym.id) << "()) return false;\n";
+        }
+    }
+    out << indent << "return true;\n";
+}
+
+static void emitParser(const CompiledGrammar &table, ostream &out, const string &className) {
+    const Grammar &g = table.grammar();
+
+    // Token::Type de cada terminal de la gramatica (-1 si ningun token lo produce)
+    vector<int> tokenOfTerminal(g.numTerminals, -1);
+    for (int t = 0; t <= Token::END; t++) {
+        int col = table.terminalIndex((Token::Type) t);
+        if (col >= 0) tokenOfTerminal[col] = t;
+    }
+
+    out << "// Parser generado por codegen.cpp a partir de generateGrammarRules(). NO EDITAR.\n";
+    out << "// Regenerar con: g++ -std=c++17 -O2 -pthread codegen.cpp -o codegen && ./codegen generated_parser.hpp\n";
+    out << "#pragma once\n\n#include \"classes.cpp\"\n\n";
+    out << "class " << className << " {\n";
+    out << "    public:\n";
+    out << "        // Hash de las reglas con que se genero; comparar con Grammar::fingerprint()\n";
+    out << "        static constexpr uint64_t GRAMMAR_FINGERPRINT = 0x" << hex << g.fingerprint() << dec << "ull;\n";
+    out << "        // Llamadas anidadas de no terminales antes de cortar el parseo\n";
+    out << "        static constexpr size_t MAX_DEPTH = 20000;\n\n";
+    out << "    private:\n";
+    out << "        // Cuenta la llamada mientras dura\n";
+    out << "        struct DepthGuard {\n";
+    out << "            size_t &depth;\n";
+    out << "            explicit DepthGuard(size_t &d) : depth(d) {\n                depth++;\n            }\n";
+    out << "            ~DepthGuard() {\n                depth--;\n            }\n";
+    out << "        };\n\n";
+    out << "        TokenStream tokens;\n";
+    out << "        Token cur;\n";
+    out << "        size_t failOffset;\n";
+    out << "        size_t depth;\n";
+    out << "        bool tooDeep;\n\n";
+    out << "        void advance() {\n            cur = tokens.next();\n        }\n\n";
+    out << "        bool fail() {\n            failOffset = cur.offset;\n            return false;\n        }\n\n";
+    out << "        bool failDepth() {\n            tooDeep = true;\n            return fail();\n        }\n\n";
+    for (int nt = g.numTerminals; nt < g.symbolCount(); nt++) {
+        out << "        bool " << functionName(g, nt) << "();\n";
+    }
+    out << "\n    public:\n";
+    out << "        explicit " << className << "(Scanner *s) : tokens(s), cur(Token::END) {\n";
+    out << "            failOffset = 0;\n            depth = 0;\n            tooDeep = false;\n        }\n\n";
+    out << "        void setScanner(Scanner *s) {\n            tokens.setScanner(s);\n        }\n\n";
+    out << "        // Devuelve true si el input pertenece al lenguaje; si no, errorOffset()\n";
+    out << "        // indica el token donde fallo. No hay recuperacion de errores.\n";
+    out << "        bool parse() {\n";
+    out << "            depth = 0;\n";
+    out << "            tooDeep = false;\n";
+    out << "            tokens.start(false);\n";
+    out << "            advance();\n";
+    out << "            bool ok = " << functionName(g, g.startSymbol()) << "() && (cur.type == Token::END || fail());\n";
+    out << "            tokens.stop();\n";
+    out << "            return ok;\n";
+    out << "        }\n\n";
+    out << "        size_t errorOffset() const {\n            return failOffset;\n        }\n\n";
+    out << "        // El ultimo parse() fallo por pasar MAX_DEPTH, no por un error de sintaxis\n";
+    out << "        bool depthExceeded() const {\n            return tooDeep;\n        }\n";
+    out << "};\n";
+
+    for (int nt = g.numTerminals; nt < g.symbolCount(); nt++) {
+        // Para cada regla, los tokens que la predicen segun la tabla LL(1)
+        vector<vector<int>> casesByRule(g.rules.size());
+        for (int t = 0; t <= Token::END; t++) {
+            int col = table.terminalIndex((Token::Type) t);
+            if (col < 0) continue;
+            int ruleIdx = table.predict(nt, col);
+            if (ruleIdx >= 0) casesByRule[ruleIdx].push_back(t);
+        }
+
+        bool loops = false;
+        for (int r : g.rulesFor(nt)) {
+            const ProdRule &rule = g.rules[r];
+            if (!casesByRule[r].empty() && rule.rhs.back().id == nt && rule.rhs.back().type == NON_TERMINAL) loops = true;
+        }
+
+        out << "\ninline bool " << className << "::" << functionName(g, nt) << "() {\n";
+        out << "    DepthGuard guard(depth);\n";
+        out << "    if (depth > MAX_DEPTH) return failDepth();\n";
+        out << (loops ? "    for (;;) {\n" : "    {\n");
+        out << "        switch (cur.type) {\n";
+        for (int r : g.rulesFor(nt)) {
+            if (casesByRule[r].empty()) continue;
+            for (int t : casesByRule[r]) out << "            case " << tokenTypeName((Token::Type) t) << ":\n";
+            out << "            {\n";
+            // Si la regla empieza con un terminal y solo ese token la predice, el switch ya lo verifico
+            const Symbol &first = g.rules[r].rhs[0];
+            bool firstChecked = first.type == TERMINAL && casesByRule[r].size() == 1
+                                && tokenOfTerminal[first.id] == casesByRule[r][0];
+            emitRuleBody(out, g, r, tokenOfTerminal, firstChecked);
+            out << "            }\n";
+        }
+        out << "            default:\n";
+        out << "                return fail();\n";
+        out << "        }\n";
+        out << "    }\n";
+        out << "}\n";
+    }
+}
+
+int main(int argc, char **argv) {
+    shared_ptr<const CompiledGrammar> language = CompiledGrammar::compile(generateGrammarRules());
+    if (!language->conflicts().empty()) {
+        // Se listan todas las celdas en conflicto para poder corregirlas de una vez
+        const Grammar &g = language->grammar();
+        cerr << "Gramatica no es LL1! " << language->conflicts().size() << " conflictos:" << endl;
+        for (const GrammarConflict &c : language->conflicts()) {
+            cerr << "  (" << g.name(c.nonTerm) << ", " << g.name(c.term) << "): regla " << c.kept
+                 << " contra regla " << c.rejected << endl;
+        }
+        return 1;
+    }
+    const Grammar &g = language->grammar();
+    if (!g.productive(g.startSymbol())) {
+        cerr << "Gramatica vacia: " << g.name(g.startSymbol()) << " no deriva ninguna cadena" << endl;
+        return 1;
+    }
+    ostringstream code;
+    emitParser(*language, code, "GeneratedParser");
+
+    if (argc > 1) {
+        ofstream file(argv[1]);
+        if (!file) {
+            cerr << "No se pudo escribir " << argv[1] << endl;
+            return 1;
+        }
+        file << code.str();
+    } else {
+        cout << code.str();
+    }
+    return 0;
+}
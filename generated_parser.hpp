@@ -0,0 +1,309 @@
+// Parser generado por codegen.cpp a partir de generateGrammarRules(). NO EDITAR.
+// Regenerar con: g++ -std=c++17 -O2 -pthread codegen.cpp -o codegen && ./codegen generated_parser.hpp
+#pragma once
+
+#include "classes.cpp"
+
+class GeneratedParser {
+    public:
+        // Hash de las reglas con que se genero; comparar con Grammar::fingerprint()
+        static constexpr uint64_t GRAMMAR_FINGERPRINT = 0x56f5bd7a046ce768ull;
+        // Llamadas anidadas de no terminales antes de cortar el parseo
+        static constexpr size_t MAX_DEPTH = 20000;
+
+    private:
+        // Cuenta la llamada mientras dura
+        struct DepthGuard {
+            size_t &depth;
+            explicit DepthGuard(size_t &d) : depth(d) {
+                depth++;
+            }
+            ~DepthGuard() {
+                depth--;
+            }
+        };
+
+        TokenStream tokens;
+        Token cur;
+        size_t failOffset;
+        size_t depth;
+        bool tooDeep;
+
+        void advance() {
+            cur = tokens.next();
+        }
+
+        bool fail() {
+            failOffset = cur.offset;
+            return false;
+        }
+
+        bool failDepth() {
+            tooDeep = true;
+            return fail();
+        }
+
+        bool parse_P_11();
+        bool parse_SL_12();
+        bool parse_S_13();
+        bool parse_SL_p_14();
+        bool parse_E_15();
+        bool parse_T_16();
+        bool parse_E_p_17();
+        bool parse_F_18();
+        bool parse_T_p_19();
+
+    public:
+        explicit GeneratedParser(Scanner *s) : tokens(s), cur(Token::END) {
+            failOffset = 0;
+            depth = 0;
+            tooDeep = false;
+        }
+
+        void setScanner(Scanner *s) {
+            tokens.setScanner(s);
+        }
+
+        // Devuelve true si el input pertenece al lenguaje; si no, errorOffset()
+        // indica el token donde fallo. No hay recuperacion de errores.
+        bool parse() {
+            depth = 0;
+            tooDeep = false;
+            tokens.start(false);
+            advance();
+            bool ok = parse_P_11() && (cur.type == Token::END || fail());
+            tokens.stop();
+            return ok;
+        }
+
+        size_t errorOffset() const {
+            return failOffset;
+        }
+
+        // El ultimo parse() fallo por pasar MAX_DEPTH, no por un error de sintaxis
+        bool depthExceeded() const {
+            return tooDeep;
+        }
+};
+
+inline bool GeneratedParser::parse_P_11() {
+    DepthGuard guard(depth);
+    if (depth > MAX_DEPTH) return failDepth();
+    {
+        switch (cur.type) {
+            case Token::ID:
+            case Token::PRINT:
+            {
+                // P -> SL
+                if (!parse_SL_12()) return false;
+                return true;
+            }
+            default:
+                return fail();
+        }
+    }
+}
+
+inline bool GeneratedParser::parse_SL_12() {
+    DepthGuard guard(depth);
+    if (depth > MAX_DEPTH) return failDepth();
+    {
+        switch (cur.type) {
+            case Token::ID:
+            case Token::PRINT:
+            {
+                // SL -> S SL'
+                if (!parse_S_13()) return false;
+                if (!parse_SL_p_14()) return false;
+                return true;
+            }
+            default:
+                return fail();
+        }
+    }
+}
+
+inline bool GeneratedParser::parse_S_13() {
+    DepthGuard guard(depth);
+    if (depth > MAX_DEPTH) return failDepth();
+    {
+        switch (cur.type) {
+            case Token::ID:
+            {
+                // S -> ID = E
+                advance();
+                if (cur.type != Token::ASSIGN) return fail();
+                advance();
+                if (!parse_E_15()) return false;
+                return true;
+            }
+            case Token::PRINT:
+            {
+                // S -> print ( E )
+                advance();
+                if (cur.type != Token::LP) return fail();
+                advance();
+                if (!parse_E_15()) return false;
+                if (cur.type != Token::RP) return fail();
+                advance();
+                return true;
+            }
+            default:
+                return fail();
+        }
+    }
+}
+
+inline bool GeneratedParser::parse_SL_p_14() {
+    DepthGuard guard(depth);
+    if (depth > MAX_DEPTH) return failDepth();
+    for (;;) {
+        switch (cur.type) {
+            case Token::SEMI:
+            {
+                // SL' -> ; S SL'
+                advance();
+                if (!parse_S_13()) return false;
+                continue;
+            }
+            case Token::END:
+            {
+                // SL' -> epsilon
+                return true;
+            }
+            default:
+                return fail();
+        }
+    }
+}
+
+inline bool GeneratedParser::parse_E_15() {
+    DepthGuard guard(depth);
+    if (depth > MAX_DEPTH) return failDepth();
+    {
+        switch (cur.type) {
+            case Token::ID:
+            case Token::NUM:
+            case Token::LP:
+            {
+                // E -> T E'
+                if (!parse_T_16()) return false;
+                if (!parse_E_p_17()) return false;
+                return true;
+            }
+            default:
+                return fail();
+        }
+    }
+}
+
+inline bool GeneratedParser::parse_T_16() {
+    DepthGuard guard(depth);
+    if (depth > MAX_DEPTH) return failDepth();
+    {
+        switch (cur.type) {
+            case Token::ID:
+            case Token::NUM:
+            case Token::LP:
+            {
+                // T -> F T'
+                if (!parse_F_18()) return false;
+                if (!parse_T_p_19()) return false;
+                return true;
+            }
+            default:
+                return fail();
+        }
+    }
+}
+
+inline bool GeneratedParser::parse_E_p_17() {
+    DepthGuard guard(depth);
+    if (depth > MAX_DEPTH) return failDepth();
+    for (;;) {
+        switch (cur.type) {
+            case Token::PLUS:
+            {
+                // E' -> + T E'
+                advance();
+                if (!parse_T_16()) return false;
+                continue;
+            }
+            case Token::MIN:
+            {
+                // E' -> - T E'
+                advance();
+                if (!parse_T_16()) return false;
+                continue;
+            }
+            case Token::SEMI:
+            case Token::RP:
+            case Token::END:
+            {
+                // E' -> epsilon
+                return true;
+            }
+            default:
+                return fail();
+        }
+    }
+}
+
+inline bool GeneratedParser::parse_F_18() {
+    DepthGuard guard(depth);
+    if (depth > MAX_DEPTH) return failDepth();
+    {
+        switch (cur.type) {
+            case Token::ID:
+            {
+                // F -> ID
+                advance();
+                return true;
+            }
+            case Token::NUM:
+            {
+                // F -> NUM
+                advance();
+                return true;
+            }
+            case Token::LP:
+            {
+                // F -> ( E )
+                advance();
+                if (!parse_E_15()) return false;
+                if (cur.type != Token::RP) return fail();
+                advance();
+                return true;
+            }
+            default:
+                return fail();
+        }
+    }
+}
+
+inline bool GeneratedParser::parse_T_p_19() {
+    DepthGuard guard(depth);
+    if (depth > MAX_DEPTH) return failDepth();
+    for (;;) {
+        switch (cur.type) {
+            case Token::MUL:
+            {
+                // T' -> * F T'
+                advance();
+                if (!parse_F_18()) return false;
+                continue;
+            }
+            case Token::SEMI:
+            case Token::RP:
+            case Token::PLUS:
+            case Token::MIN:
+            case Token::END:
+            {
+                // T' -> epsilon
+                return true;
+            }
+            default:
+                return fail();
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "classes.cpp"
+
+using namespace std;
+
+// Primero generamos la gramatica con sus terminales y no terminales / reglas de prd.
+// Se escribe en forma natural, con recursion por izquierda; Grammar la transforma
+// (GrammarTransform) en SL', E' y T', las mismas reglas que lang::GRAMMAR.
+vector<ProdRule> generateGrammarRules() {   
+    Symbol id("ID", TERMINAL);
+    Symbol num("NUM", TERMINAL);
+    Symbol assign("=", TERMINAL);
+    Symbol print("print", TERMINAL);
+    Symbol lparen("(", TERMINAL);
+    Symbol rparen(")", TERMINAL);
+    Symbol plus("+", TERMINAL);
+    Symbol minus("-", TERMINAL);
+    Symbol mul("*", TERMINAL);
+    Symbol semicolon(";", TERMINAL);
+
+    Symbol program("P", NON_TERMINAL);
+    Symbol stmList("SL", NON_TERMINAL);
+    Symbol stmt("S", NON_TERMINAL);
+    Symbol exp("E", NON_TERMINAL);
+    Symbol term("T", NON_TERMINAL);
+    Symbol factor("F", NON_TERMINAL);
+
+    // Guardamos ls reglas de produccion en el vector de producction rules: 
+    vector<ProdRule> rules;
+
+    // P -> SL
+    rules.emplace_back( program.value,vector<Symbol>{stmList});
+    
+    // SL -> SL ; S | S
+    rules.emplace_back( stmList.value,vector<Symbol>{stmList, semicolon, stmt});
+    rules.emplace_back( stmList.value,vector<Symbol>{stmt});
+
+    // S -> id = E | print(E)
+    rules.emplace_back( stmt.value,vector<Symbol>{id, assign, exp});
+    rules.emplace_back( stmt.value,vector<Symbol>{print, lparen, exp, rparen});
+
+    // E -> E + T | E - T | T
+    rules.emplace_back( exp.value,vector<Symbol>{exp, plus, term});
+    rules.emplace_back( exp.value,vector<Symbol>{exp, minus, term});
+    rules.emplace_back( exp.value,vector<Symbol>{term});
+
+    // T -> T * F | F
+    rules.emplace_back( term.value,vector<Symbol>{term, mul, factor});
+    rules.emplace_back( term.value,vector<Symbol>{factor});
+
+    // F -> id  | num | (E)
+    rules.emplace_back(factor.value,vector<Symbol>{id});
+    rules.emplace_back(factor.value, vector<Symbol>{num});
+    rules.emplace_back( factor.value,vector<Symbol>{lparen, exp, rparen});
+
+    return rules;
+}
+
+
+// La misma gramatica como dato constexpr. Los IDs siguen el orden en que Grammar
+// interna los simbolos de generateGrammarRules(), asi ambas versiones coinciden;
+// tests.cpp falla si las reglas o la tabla se separan de las calculadas.
+namespace lang {
+    enum Symbols : int {
+        END_, SEMI, ID, ASSIGN, PRINT, LP, RP, PLUS, MIN, MUL, NUM,
+        P, SL, S, SL_P, E, T, E_P, F, T_P
+    };
+
+    inline constexpr StaticGrammar<11, 9, 16> GRAMMAR = {
+        {"$", ";", "ID", "=", "print", "(", ")", "+", "-", "*", "NUM",
+         "P", "SL", "S", "SL'", "E", "T", "E'", "F", "T'"},
+        {{
+            {P, 1, {SL}},
+            {SL, 2, {S, SL_P}},
+            {SL_P, 3, {SEMI, S, SL_P}},
+            {SL_P, 0, {}},
+            {S, 3, {ID, ASSIGN, E}},
+            {S, 4, {PRINT, LP, E, RP}},
+            {E, 2, {T, E_P}},
+            {E_P, 3, {PLUS, T, E_P}},
+            {E_P, 3, {MIN, T, E_P}},
+            {E_P, 0, {}},
+            {T, 2, {F, T_P}},
+            {T_P, 3, {MUL, F, T_P}},
+            {T_P, 0, {}},
+            {F, 1, {ID}},
+            {F, 1, {NUM}},
+            {F, 3, {LP, E, RP}},
+        }}
+    };
+
+    inline constexpr StaticTables<11, 9, 16> TABLES = computeStaticTables(GRAMMAR);
+    static_assert(TABLES.conflictNonTerm < 0, "Gramatica no es LL1!");
+}
+
+// Grammar lista para usar, sin calcular FIRST/FOLLOW ni la tabla en tiempo de ejecucion
+inline Grammar staticGrammar() {
+    return Grammar(lang::GRAMMAR, lang::TABLES);
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include "classes.cpp"
+
+using namespace std;
+
+// Documento con reparseo incremental. El texto se guarda partido en sentencias
+// por los separadores de nivel superior (como ParallelParser); cada sentencia
+// tiene su propio texto, su resultado y sus diagnosticos con offsets relativos
+// a su inicio. Una edicion re-lexea y reparsea solo la ventana de sentencias
+// que toca, extendida hasta el primer separador viejo que vuelve a quedar a
+// nivel superior: desde ahi el resto del texto es identico y se reusa.
+// La recuperacion de errores empieza de nuevo en cada sentencia, asi que un
+// error en cascada que cruza un separador puede reportarse una vez por sentencia.
+class Document {
+    private:
+        struct Statement {
+            string text;                      // sin el separador que la sigue
+            size_t begin;                     // offset en el documento, ver beginOf()
+            bool ok;
+            vector<Diagnostic> diagnostics;   // offsets relativos a begin
+        };
+
+        shared_ptr<const CompiledGrammar> language;
+        QuietParser parser;
+        int listSymbol;
+        char separator;
+        Token::Type separatorToken;
+        size_t length;
+        // Entre cada par de sentencias hay exactamente un separador. Las sentencias
+        // estan en un buffer con hueco: las [0, gapBegin) al principio de slots y el
+        // resto al final, despues de gapSize lugares libres. Una edicion mueve el
+        // hueco hasta su ventana, asi agregar o sacar sentencias cuesta la distancia
+        // entre ediciones sucesivas, igual que el corrimiento pendiente.
+        vector<Statement> slots;
+        size_t gapBegin;
+        size_t gapSize;
+        // Corrimiento pendiente: las sentencias desde pendingFrom estan corridas en
+        // pendingDelta. Mover el limite cuesta la distancia entre ediciones sucesivas,
+        // no la cantidad de sentencias.
+        size_t pendingFrom;
+        size_t pendingDelta;   // aritmetica modular: un corrimiento negativo da la vuelta
+
+        size_t count() const {
+            return slots.size() - gapSize;
+        }
+
+        Statement &at(size_t i) {
+            return slots[i < gapBegin ? i : i + gapSize];
+        }
+
+        const Statement &at(size_t i) const {
+            return slots[i < gapBegin ? i : i + gapSize];
+        }
+
+        void moveGapTo(size_t idx) {
+            if (gapSize == 0) {
+                gapBegin = idx;
+                return;
+            }
+            for (; gapBegin > idx; gapBegin--) slots[gapBegin - 1 + gapSize] = std::move(slots[gapBegin - 1]);
+            for (; gapBegin < idx; gapBegin++) slots[gapBegin] = std::move(slots[gapBegin + gapSize]);
+        }
+
+        // Agranda el hueco (que esta en gapBegin) a por lo menos need lugares;
+        // duplica el buffer, asi el costo amortizado por sentencia es constante
+        void growGap(size_t need) {
+            size_t used = count(), newGap = max(need, used + 16);
+            vector<Statement> grown(used + newGap);
+            for (size_t i = 0; i < gapBegin; i++) grown[i] = std::move(slots[i]);
+            for (size_t i = gapBegin; i < used; i++) grown[i + newGap] = std::move(slots[i + gapSize]);
+            slots = std::move(grown);
+            gapSize = newGap;
+        }
+
+        Statement parseStatement(string text, size_t begin, bool last) {
+            Scanner scanner{string_view(text)};
+            parser.setScanner(&scanner);
+            bool ok = parser.parse(nullptr, listSymbol);
+            Statement stmt{std::move(text), begin, ok, parser.lastResult().diagnostics};
+            for (Diagnostic &d : stmt.diagnostics) {
+                // El fin de la sentencia es el separador en el documento completo
+                if (!last && d.found == Token::END && d.offset == stmt.text.size()) d.found = separatorToken;
+            }
+            return stmt;
+        }
+
+        void movePendingTo(size_t idx) {
+            for (; pendingFrom < idx; pendingFrom++) at(pendingFrom).begin += pendingDelta;
+            for (; pendingFrom > idx; pendingFrom--) at(pendingFrom - 1).begin -= pendingDelta;
+        }
+
+        // Ultima sentencia que empieza en offset o antes
+        size_t statementAt(size_t offset) const {
+            size_t lo = 0, hi = count();
+            while (hi - lo > 1) {
+                size_t mid = (lo + hi) / 2;
+                if (beginOf(mid) <= offset) lo = mid;
+                else hi = mid;
+            }
+            return lo;
+        }
+
+        // Parte window (que empieza a profundidad cero) en sentencias. Cuando se
+        // acaba la ventana y la profundidad no es cero, el separador viejo que sigue
+        // no es de nivel superior: se agrega la proxima sentencia vieja y se sigue.
+        // Devuelve el indice de la primera sentencia vieja que se reusa.
+        size_t rescan(string window, size_t begin, size_t next, vector<Statement> &fresh) {
+            size_t start = 0;
+            long depth = 0;
+            for (size_t i = 0;; i++) {
+                if (i == window.size()) {
+                    if (next == count()) break;
+                    if (depth == 0) {
+                        fresh.push_back(parseStatement(window.substr(start), begin + start, false));
+                        return next;
+                    }
+                    window += separator;
+                    window += at(next++).text;
+                }
+                char c = window[i];
+                if (c == '(') depth++;
+                else if (c == ')') depth = depth > 0 ? depth - 1 : 0;
+                else if (c == separator && depth == 0) {
+                    fresh.push_back(parseStatement(window.substr(start, i - start), begin + start, false));
+                    start = i + 1;
+                }
+            }
+            fresh.push_back(parseStatement(window.substr(start), begin + start, true));
+            return next;
+        }
+
+    public:
+        Document(shared_ptr<const CompiledGrammar> compiled, string_view text, const string &listName = "SL",
+                 char sep = ';')
+            : language(compiled), parser(nullptr, compiled) {
+            const Grammar &g = language->grammar();
+            listSymbol = g.symbolId(listName);
+            if (listSymbol < g.numTerminals) listSymbol = g.startSymbol();
+            separator = sep;
+            separatorToken = Scanner(string_view(&separator, 1)).nextToken().type;
+            length = text.size();
+            pendingFrom = 0;
+            pendingDelta = 0;
+            // rescan lee las sentencias viejas: se arma aparte y se asigna al
+            // final, si no un '(' sin cerrar agregaria su propia salida
+            gapBegin = 0;
+            gapSize = 0;
+            vector<Statement> initial;
+            rescan(string(text), 0, 0, initial);
+            slots = std::move(initial);
+            gapBegin = slots.size();
+        }
+
+        // Reemplaza removed bytes desde offset por inserted y reparsea lo afectado.
+        // Devuelve la cantidad de sentencias que se volvieron a parsear. Cuesta
+        // O(bytes de la ventana) en lexeo y parseo, mas mover el hueco y el
+        // corrimiento pendiente desde la edicion anterior.
+        size_t edit(size_t offset, size_t removed, string_view inserted) {
+            offset = min(offset, length);
+            removed = min(removed, length - offset);
+
+            // Ventana: las sentencias que tocan [offset, offset + removed], con sus separadores
+            size_t first = statementAt(offset);
+            size_t begin = beginOf(first);
+            size_t local = offset - begin;
+            size_t next = first + 1;
+            string window = at(first).text;
+            while (local + removed > window.size()) {
+                window += separator;
+                window += at(next++).text;
+            }
+            window.replace(local, removed, inserted.data(), inserted.size());
+
+            vector<Statement> fresh;
+            next = rescan(std::move(window), begin, next, fresh);
+
+            // Las sentencias reusadas se corren en inserted - removed
+            movePendingTo(next);
+            pendingDelta += inserted.size() - removed;
+            length += inserted.size() - removed;
+            // Las sentencias de la ventana pasan al hueco y las nuevas ocupan su lugar
+            moveGapTo(next);
+            for (size_t i = first; i < next; i++) slots[i] = Statement();
+            gapBegin = first;
+            gapSize += next - first;
+            if (fresh.size() > gapSize) growGap(fresh.size());
+            for (Statement &stmt : fresh) {
+                slots[gapBegin++] = std::move(stmt);
+                gapSize--;
+            }
+            pendingFrom = first + fresh.size();
+            return fresh.size();
+        }
+
+        size_t size() const {
+            return length;
+        }
+
+        // Arma el texto completo; cuesta O(tamano del documento)
+        string text() const {
+            string out;
+            out.reserve(length);
+            for (size_t i = 0; i < count(); i++) {
+                if (i) out += separator;
+                out += at(i).text;
+            }
+            return out;
+        }
+
+        size_t statementCount() const {
+            return count();
+        }
+
+        size_t beginOf(size_t i) const {
+            return at(i).begin + (i >= pendingFrom ? pendingDelta : 0);
+        }
+
+        const string &statementText(size_t i) const {
+            return at(i).text;
+        }
+
+        bool ok() const {
+            for (size_t i = 0; i < count(); i++) {
+                if (!at(i).ok) return false;
+            }
+            return true;
+        }
+
+        // Diagnosticos de todo el documento, con offsets absolutos y en orden
+        vector<Diagnostic> diagnostics() const {
+            vector<Diagnostic> all;
+            for (size_t i = 0; i < count(); i++) {
+                for (Diagnostic d : at(i).diagnostics) {
+                    d.offset += beginOf(i);
+                    all.push_back(d);
+                }
+            }
+            return all;
+        }
+
+        // Arbol de parseo de la sentencia i, construido a pedido; los offsets de
+        // los nodos son relativos a statementText(i)
+        bool statementTree(size_t i, ParseTree &out) {
+            Scanner scanner{string_view(at(i).text)};
+            parser.setScanner(&scanner);
+            return parser.parse(&out, listSymbol);
+        }
+};
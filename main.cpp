@@ -1,93 +1,103 @@
 #include <iostream>
 #include "classes.cpp"
+#include "grammar_rules.cpp"
+#include "vm.cpp"
+#include "generated_parser.hpp"
 
 using namespace std;
 
-// Primero generamos la gramatica con sus terminales y no terminales / reglas de prd: 
-vector<ProdRule> generateGrammarRules() {   
-    Symbol id("ID", TERMINAL);
-    Symbol num("NUM", TERMINAL);
-    Symbol assign("=", TERMINAL);
-    Symbol print("print", TERMINAL);
-    Symbol lparen("(", TERMINAL);
-    Symbol rparen(")", TERMINAL);
-    Symbol plus("+", TERMINAL);
-    Symbol minus("-", TERMINAL);
-    Symbol mul("*", TERMINAL);
-    Symbol semicolon(";", TERMINAL);
-    Symbol epsilon("epsilon", EPSILON);
-
-    Symbol program("P", NON_TERMINAL);
-    Symbol stmList("SL", NON_TERMINAL);
-    Symbol stmListPrime("SL'", NON_TERMINAL);
-    Symbol stmt("S", NON_TERMINAL);
-    Symbol exp("E", NON_TERMINAL);
-    Symbol expPrime("E'", NON_TERMINAL);
-    Symbol term("T", NON_TERMINAL);
-    Symbol termPrime("T'", NON_TERMINAL);
-    Symbol factor("F", NON_TERMINAL);
-
-    // Guardamos ls reglas de produccion en el vector de producction rules: 
-    vector<ProdRule> rules;
-
-    // P -> SL
-    rules.emplace_back( program.value,vector<Symbol>{stmList});
-    
-    // SL -> S SL'
-    rules.emplace_back( stmList.value,vector<Symbol>{stmt, stmListPrime});
-
-    // SL' -> SL | epsilon
-    rules.emplace_back( stmListPrime.value, vector<Symbol>{semicolon, stmt, stmListPrime});
-    rules.emplace_back( stmListPrime.value,vector<Symbol>{epsilon});
-
-    // S -> id = E | print(E)
-    rules.emplace_back( stmt.value,vector<Symbol>{id, assign, exp});
-    rules.emplace_back( stmt.value,vector<Symbol>{print, lparen, exp, rparen});
-
-    // E -> T E' 
-    rules.emplace_back( exp.value,vector<Symbol>{term, expPrime});
-
-    // E' -> + T E' - T E'  | epsilon
-    rules.emplace_back( expPrime.value,vector<Symbol>{plus, term, expPrime});
-    rules.emplace_back( expPrime.value,vector<Symbol>{minus, term, expPrime});
-    rules.emplace_back( expPrime.value,vector<Symbol>{epsilon});
-
-    // T -> F T' 
-    rules.emplace_back( term.value,vector<Symbol>{factor, termPrime});
-
-    // T' -> * F T' | epsilon
-    rules.emplace_back( termPrime.value,vector<Symbol>{mul, factor, termPrime});
-    rules.emplace_back( termPrime.value, vector<Symbol>{epsilon});
-
-    // F -> id  | num | (E)
-    rules.emplace_back(factor.value,vector<Symbol>{id});
-    rules.emplace_back(factor.value, vector<Symbol>{num});
-    rules.emplace_back( factor.value,vector<Symbol>{lparen, exp, rparen});
-
-    return rules;
+// Valida un archivo con el parser generado; si falla, o si fue generado para otra
+// gramatica, vuelve a parsear con el parser de tabla para reportar los errores.
+// El parser generado tambien falla si el anidamiento pasa GeneratedParser::MAX_DEPTH;
+// el de tabla no usa el stack de llamadas y decide el input a cualquier profundidad.
+static int checkFile(const char *path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        cerr << "No se pudo abrir " << path << endl;
+        return 1;
+    }
+
+    shared_ptr<const CompiledGrammar> language = CompiledGrammar::compile(staticGrammar());
+    const Grammar &grammar = language->grammar();
+    if (grammar.fingerprint() == GeneratedParser::GRAMMAR_FINGERPRINT) {
+        Scanner scanner(file);
+        GeneratedParser fast(&scanner);
+        if (fast.parse()) {
+            cout << path << ": OK" << endl;
+            return 0;
+        }
+    } else {
+        cerr << "generated_parser.hpp no corresponde a la gramatica; usando el parser de tabla" << endl;
+    }
+
+    Scanner scanner(file);
+    QuietParser parser(&scanner, language);
+    parser.setErrorLimit(100);
+    bool ok = parser.parse();
+    SourceLocator locator(file.view());
+    for (const Diagnostic &d : parser.lastResult().diagnostics) {
+        SourceLocation loc = locator.locate(d.offset);
+        cout << path << ":" << loc.line << ":" << loc.column << ": ";
+        if (d.kind == Diagnostic::EXPECTED) {
+            cout << "se esperaba: " << grammar.name(d.expected) << ". Se obtuvo: " << Token(d.found).toString() << endl;
+        } else if (d.kind == Diagnostic::GRAMMAR) {
+            cout << "la gramatica tiene conflictos en " << grammar.name(d.expected) << ", no se parseo" << endl;
+        } else if (d.kind == Diagnostic::EMPTY) {
+            cout << "la gramatica no genera ninguna cadena desde " << grammar.name(d.expected) << ", no se parseo" << endl;
+        } else if (d.kind == Diagnostic::UNEXPECTED) {
+            cout << "token inesperado: " << Token(d.found).toString() << endl;
+        } else {
+            cout << "input sobrante: " << Token(d.found).toString() << endl;
+        }
+    }
+    if (parser.lastResult().aborted) cout << path << ": demasiados errores, se detuvo el parseo" << endl;
+    cout << path << (ok ? ": OK" : ": con errores") << endl;
+    return ok ? 0 : 1;
 }
 
-int main() {
-    //Test correcto:
-    auto *grammar = new Grammar(generateGrammarRules());
-    auto *scanner = new Scanner("x=5; print(x)");
-    auto *parser = new Parser(scanner, grammar);
-
-    parser->parse();
+// Parsea el archivo con contadores y muestra donde se va el tiempo: tokens por
+// tipo, reglas mas aplicadas, profundidad del stack y recuperacion de errores
+static int profileFile(const char *path, bool json) {
+    MappedFile file;
+    if (!file.open(path)) {
+        cerr << "No se pudo abrir " << path << endl;
+        return 1;
+    }
+
+    shared_ptr<const CompiledGrammar> language = CompiledGrammar::compile(staticGrammar());
+    Scanner scanner(file);
+    ProfilingParser parser(&scanner, language);
+    bool ok = parser.parse();
+    if (json) parser.tracer().profile.printJson(cout, language->grammar());
+    else parser.tracer().profile.print(cout, language->grammar());
+    return ok ? 0 : 1;
+}
 
-    delete grammar;
-    delete scanner;
-    delete parser;
+int main(int argc, char **argv) {
+    if (argc > 2 && (string(argv[1]) == "--perfil" || string(argv[1]) == "--perfil-json")) {
+        return profileFile(argv[2], string(argv[1]) == "--perfil-json");
+    }
+    if (argc > 1) return checkFile(argv[1]);
 
-    //Test con manejo de errores: 
-    auto *grammar2 = new Grammar(generateGrammarRules());
-    auto *scanner2 = new Scanner("x=5; print(x;)");
-    auto *parser2 = new Parser(scanner2, grammar2);
-    parser2->parse();
-    delete grammar2;
-    delete scanner2;
-    delete parser2;
+    // Una sola gramatica compilada, compartida por todos los parsers
+    shared_ptr<const CompiledGrammar> language = CompiledGrammar::compile(staticGrammar());
 
+    //Test correcto:
+    Scanner scanner("x=5; print(x)");
+    Parser parser(&scanner, language);
+    parser.parse();
+
+    //Test con manejo de errores: el mismo scanner y parser sobre otro input
+    scanner.reset("x=5; print(x;)");
+    parser.parse();
+
+    //Ejecucion del programa compilado a bytecode:
+    Bytecode bytecode;
+    if (compileProgram(language, "x=5; y=x*(x-2); print(x+y)", bytecode)) {
+        VM vm;
+        vm.run(bytecode);
+        for (int64_t value : vm.output) cout << value << endl;
+    }
     
     return 0;
 }
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include "classes.cpp"
+
+using namespace std;
+
+// Pool de hilos con robo de trabajo. Cada worker tiene su propia cola: toma
+// tareas del final de la suya y, cuando se vacia, roba del frente de las demas.
+class WorkStealingPool {
+    private:
+        struct Queue {
+            mutex m;
+            deque<size_t> tasks;
+        };
+
+        vector<unique_ptr<Queue>> queues;
+        vector<thread> workers;
+
+        mutex jobMutex;
+        condition_variable jobReady;
+        condition_variable jobDone;
+        function<void(size_t, size_t)> job;
+        size_t generation;
+        size_t remaining;
+        bool shutdown;
+
+        bool takeTask(size_t worker, size_t &task) {
+            {
+                Queue &own = *queues[worker];
+                lock_guard<mutex> lock(own.m);
+                if (!own.tasks.empty()) {
+                    task = own.tasks.back();
+                    own.tasks.pop_back();
+                    return true;
+                }
+            }
+            for (size_t i = 1; i < queues.size(); i++) {
+                Queue &victim = *queues[(worker + i) % queues.size()];
+                lock_guard<mutex> lock(victim.m);
+                if (!victim.tasks.empty()) {
+                    task = victim.tasks.front();
+                    victim.tasks.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void workerLoop(size_t worker) {
+            size_t seen = 0;
+            while (true) {
+                {
+                    unique_lock<mutex> lock(jobMutex);
+                    jobReady.wait(lock, [&] { return shutdown || generation != seen; });
+                    if (shutdown) return;
+                    seen = generation;
+                }
+                size_t task;
+                while (takeTask(worker, task)) {
+                    job(task, worker);
+                    lock_guard<mutex> lock(jobMutex);
+                    if (--remaining == 0) jobDone.notify_all();
+                }
+            }
+        }
+
+    public:
+        explicit WorkStealingPool(size_t threads) {
+            if (threads == 0) threads = 1;
+            generation = 0;
+            remaining = 0;
+            shutdown = false;
+            for (size_t i = 0; i < threads; i++) queues.emplace_back(new Queue());
+            for (size_t i = 0; i < threads; i++) workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+        }
+
+        WorkStealingPool(const WorkStealingPool &) = delete;
+        WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+        size_t size() const {
+            return workers.size();
+        }
+
+        // Ejecuta fn(tarea, worker) para cada tarea en [0, count) y espera a que terminen.
+        // Las tareas se reparten en bloques contiguos, uno por worker.
+        void parallelFor(size_t count, const function<void(size_t, size_t)> &fn) {
+            if (count == 0) return;
+            unique_lock<mutex> lock(jobMutex);
+            job = fn;
+            size_t n = queues.size();
+            for (size_t w = 0; w < n; w++) {
+                lock_guard<mutex> qlock(queues[w]->m);
+                for (size_t t = count * w / n; t < count * (w + 1) / n; t++) queues[w]->tasks.push_back(t);
+            }
+            remaining = count;
+            generation++;
+            jobReady.notify_all();
+            jobDone.wait(lock, [&] { return remaining == 0; });
+        }
+
+        ~WorkStealingPool() {
+            {
+                lock_guard<mutex> lock(jobMutex);
+                shutdown = true;
+            }
+            jobReady.notify_all();
+            for (thread &t : workers) t.join();
+        }
+};
+
+// Pre-escaneo: offsets de los separadores que estan fuera de parentesis
+inline vector<size_t> topLevelSeparators(string_view input, char separator = ';') {
+    vector<size_t> cuts;
+    long depth = 0;
+    for (size_t i = 0; i < input.size(); i++) {
+        char c = input[i];
+        if (c == '(') depth++;
+        else if (c == ')') depth = depth > 0 ? depth - 1 : 0;
+        else if (c == separator && depth == 0) cuts.push_back(i);
+    }
+    return cuts;
+}
+
+struct ParallelParseResult {
+    bool ok;
+    size_t chunks;
+    vector<Diagnostic> diagnostics;   // en orden de aparicion en el input
+};
+
+// Parseo en paralelo de listas de sentencias. Como en SL -> S SL' y
+// SL' -> ; S SL' | epsilon las sentencias a profundidad cero son independientes,
+// el input se corta en bloques de varias sentencias en separadores de nivel
+// superior y cada bloque se parsea como una lista (SL) en un worker. La
+// recuperacion de errores empieza de nuevo en cada bloque.
+class ParallelParser {
+    private:
+        shared_ptr<const CompiledGrammar> language;
+        int listSymbol;
+        char separator;
+        Token::Type separatorToken;
+        size_t chunkBytes;
+        WorkStealingPool pool;
+        vector<unique_ptr<QuietParser>> parsers;   // uno por worker, comparten la tabla
+
+    public:
+        // listSymbol es el no terminal que deriva una lista de sentencias separadas por separator
+        ParallelParser(shared_ptr<const CompiledGrammar> compiled, const string &listName = "SL", char sep = ';',
+                       size_t threads = thread::hardware_concurrency(), size_t bytesPerChunk = 1 << 16)
+            : pool(threads) {
+            language = std::move(compiled);
+            const Grammar &g = language->grammar();
+            listSymbol = g.symbolId(listName);
+            if (listSymbol < g.numTerminals) listSymbol = g.startSymbol();
+            separator = sep;
+            separatorToken = Scanner(string_view(&separator, 1)).nextToken().type;
+            chunkBytes = bytesPerChunk ? bytesPerChunk : 1;
+            for (size_t i = 0; i < pool.size(); i++) {
+                parsers.emplace_back(new QuietParser(nullptr, language));
+            }
+        }
+
+        ParallelParseResult parse(string_view input) {
+            // Cortamos en el primer separador de nivel superior despues de cada chunkBytes
+            vector<size_t> bounds = {0};
+            for (size_t cut : topLevelSeparators(input, separator)) {
+                if (cut - bounds.back() >= chunkBytes) bounds.push_back(cut + 1);
+            }
+            size_t chunks = bounds.size();
+            bounds.push_back(input.size() + 1);
+
+            vector<vector<Diagnostic>> chunkDiagnostics(chunks);
+            vector<char> chunkOk(chunks, false);
+            pool.parallelFor(chunks, [&](size_t chunk, size_t worker) {
+                // El bloque termina antes del separador que lo sigue
+                string_view text = input.substr(0, bounds[chunk + 1] - 1);
+                Scanner scanner(text, bounds[chunk]);
+                QuietParser &parser = *parsers[worker];
+                parser.setScanner(&scanner);
+                chunkOk[chunk] = parser.parse(nullptr, listSymbol);
+                chunkDiagnostics[chunk] = parser.lastResult().diagnostics;
+                // El fin de un bloque que no es el ultimo es el separador en el input completo
+                if (chunk + 1 == chunks) return;
+                for (Diagnostic &d : chunkDiagnostics[chunk]) {
+                    if (d.found == Token::END && d.offset == text.size()) d.found = separatorToken;
+                }
+            });
+
+            ParallelParseResult result{true, chunks, {}};
+            for (size_t chunk = 0; chunk < chunks; chunk++) {
+                result.ok = result.ok && chunkOk[chunk];
+                result.diagnostics.insert(result.diagnostics.end(), chunkDiagnostics[chunk].begin(),
+                                          chunkDiagnostics[chunk].end());
+            }
+            return result;
+        }
+};
+
+// Parseo de muchos documentos chicos e independientes. Cada worker del pool
+// tiene su propio parser y scanner, que se reusan de un documento al siguiente,
+// asi parsear un documento no construye nada. Los documentos se reparten en
+// tareas de varios documentos para que el costo de coordinar el pool no domine
+// con inputs de pocos bytes. Con setProfile() cada worker parsea con su propio
+// ProfileTrace y los contadores se juntan en un ProfileAggregator al terminar.
+class BatchParser {
+    private:
+        struct Worker {
+            Scanner scanner{""};
+            unique_ptr<QuietParser> parser;
+            unique_ptr<ProfilingParser> profiler;   // solo si se pidio un perfil
+        };
+
+        shared_ptr<const CompiledGrammar> language;
+        size_t docsPerTask;
+        size_t errorLimit;
+        WorkStealingPool pool;
+        vector<Worker> workers;
+        ProfileAggregator *aggregator;
+
+        template <typename P>
+        static void parseRange(P &parser, Scanner &scanner, const string_view *inputs, size_t begin, size_t end,
+                               vector<ParseResult> &results) {
+            for (size_t doc = begin; doc < end; doc++) {
+                scanner.reset(inputs[doc]);
+                parser.parse();
+                results[doc] = parser.lastResult();
+            }
+        }
+
+    public:
+        BatchParser(shared_ptr<const CompiledGrammar> compiled, size_t threads = thread::hardware_concurrency(),
+                    size_t documentsPerTask = 64)
+            : pool(threads) {
+            language = std::move(compiled);
+            docsPerTask = documentsPerTask ? documentsPerTask : 1;
+            errorLimit = SIZE_MAX;
+            aggregator = nullptr;
+            workers.resize(pool.size());
+            for (Worker &w : workers) w.parser.reset(new QuietParser(&w.scanner, language));
+        }
+
+        // Limite de errores por documento (ver BasicParser::setErrorLimit)
+        void setErrorLimit(size_t limit) {
+            errorLimit = limit;
+            for (Worker &w : workers) {
+                w.parser->setErrorLimit(limit);
+                if (w.profiler) w.profiler->setErrorLimit(limit);
+            }
+        }
+
+        // Los parse() siguientes suman sus contadores en target; nullptr vuelve al
+        // parser sin traza. El ciclo de parseo no toma el lock: cada worker cuenta
+        // en su ProfileTrace y se publica una vez por worker al final de parse().
+        void setProfile(ProfileAggregator *target) {
+            aggregator = target;
+            if (!target) return;
+            for (Worker &w : workers) {
+                if (w.profiler) continue;
+                w.profiler.reset(new ProfilingParser(&w.scanner, language));
+                w.profiler->setErrorLimit(errorLimit);
+            }
+        }
+
+        size_t threads() const {
+            return pool.size();
+        }
+
+        // Parsea inputs[0, count) y devuelve un resultado por documento, en el orden
+        // de entrada; los offsets de los diagnosticos son relativos a cada documento
+        vector<ParseResult> parse(const string_view *inputs, size_t count) {
+            vector<ParseResult> results(count);
+            size_t tasks = (count + docsPerTask - 1) / docsPerTask;
+            pool.parallelFor(tasks, [&](size_t task, size_t worker) {
+                Worker &w = workers[worker];
+                size_t end = min(count, (task + 1) * docsPerTask);
+                if (aggregator) parseRange(*w.profiler, w.scanner, inputs, task * docsPerTask, end, results);
+                else parseRange(*w.parser, w.scanner, inputs, task * docsPerTask, end, results);
+            });
+            if (aggregator) {
+                for (Worker &w : workers) {
+                    aggregator->add(w.profiler->tracer().profile);
+                    w.profiler->tracer().profile = ParseProfile();
+                }
+            }
+            return results;
+        }
+
+        vector<ParseResult> parse(const vector<string_view> &inputs) {
+            return parse(inputs.data(), inputs.size());
+        }
+};
@@ -0,0 +1,386 @@
+#include <iostream>
+#include <fstream>
+#include <random>
+#include "classes.cpp"
+#include "grammar_rules.cpp"
+#include "parallel.cpp"
+#include "incremental.cpp"
+#include "generated_parser.hpp"
+
+using namespace std;
+
+// Pruebas de regresion: cada una reporta lo que no coincide y main devuelve
+// distinto de cero si alguna fallo.
+static int failures = 0;
+
+static void check(bool ok, const string &what) {
+    if (!ok) {
+        cerr << "FALLO: " << what << endl;
+        failures++;
+    }
+}
+
+static bool sameDiagnostics(const vector<Diagnostic> &a, const vector<Diagnostic> &b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].kind != b[i].kind || a[i].offset != b[i].offset || a[i].expected != b[i].expected ||
+            a[i].found != b[i].found) return false;
+    }
+    return true;
+}
+
+// lang::GRAMMAR es una copia a mano de la forma transformada de
+// generateGrammarRules(): los simbolos, las reglas, FIRST/FOLLOW y la tabla
+// tienen que ser los mismos que calcula Grammar en tiempo de ejecucion
+static void testStaticGrammar() {
+    shared_ptr<const CompiledGrammar> runtime = CompiledGrammar::compile(Grammar(generateGrammarRules()));
+    shared_ptr<const CompiledGrammar> fixed = CompiledGrammar::compile(staticGrammar());
+    const Grammar &a = runtime->grammar(), &b = fixed->grammar();
+    check(a.numTerminals == b.numTerminals && a.symbolNames == b.symbolNames, "simbolos de lang::GRAMMAR");
+    check(a.rules == b.rules, "reglas de lang::GRAMMAR");
+    check(a.fingerprint() == b.fingerprint(), "fingerprint de lang::GRAMMAR");
+    if (a.symbolCount() != b.symbolCount()) return;
+
+    bool sets = a.NULLABLE == b.NULLABLE;
+    for (int id = 0; id < a.symbolCount(); id++) {
+        sets = sets && a.FIRST[id].words == b.FIRST[id].words && a.FOLLOW[id].words == b.FOLLOW[id].words;
+    }
+    check(sets, "NULLABLE/FIRST/FOLLOW de lang::TABLES");
+    bool table = true;
+    for (int nonTerm = a.numTerminals; nonTerm < a.symbolCount(); nonTerm++) {
+        for (int term = 0; term < a.numTerminals; term++) {
+            table = table && runtime->predict(nonTerm, term) == fixed->predict(nonTerm, term);
+        }
+    }
+    check(table, "tabla de lang::TABLES");
+}
+
+// Con un bloque por sentencia, los errores que no cruzan un separador se
+// reportan igual que con el parser secuencial, incluido el separador que
+// termina cada bloque
+static void testParallelDiagnostics(const shared_ptr<const CompiledGrammar> &language) {
+    const char *inputs[] = {"x=;y=2;z=3", "x=1;y=(2;z=3", "x=1+;print(y;z=", "x=1;y=2*;z=3;", "x=1;;y=2"};
+    ParallelParser parallel(language, "SL", ';', 2, 1);
+    for (const char *input : inputs) {
+        Scanner scanner{string_view(input)};
+        QuietParser sequential(&scanner, language);
+        bool ok = sequential.parse();
+        ParallelParseResult result = parallel.parse(input);
+        check(result.ok == ok, string("ok paralelo == secuencial en ") + input);
+        check(sameDiagnostics(result.diagnostics, sequential.lastResult().diagnostics),
+              string("diagnosticos paralelo == secuencial en ") + input);
+    }
+}
+
+// Un '(' sin cerrar hace que rescan siga leyendo sentencias viejas; al construir
+// el documento no hay ninguna y el texto tiene que quedar igual
+static void testDocumentUnbalanced(const shared_ptr<const CompiledGrammar> &language) {
+    const char *inputs[] = {"x=1;(;y=2", "(", "x=1;print((y;z=2;", "x=(1;y=2);z=3"};
+    for (const char *input : inputs) {
+        Document doc(language, input);
+        check(doc.text() == input, string("Document::text() en ") + input);
+        check(doc.size() == string_view(input).size(), string("Document::size() en ") + input);
+    }
+
+    // Cerrar el parentesis despues vuelve a partir el documento en sentencias
+    Document doc(language, "x=1;(;y=2");
+    doc.edit(5, 0, "1)");
+    check(doc.text() == "x=1;(1);y=2", "Document::edit() despues de '(' sin cerrar");
+}
+
+// Ediciones al azar que agregan y sacan separadores y parentesis: el documento
+// editado tiene que quedar igual a uno construido de cero con el mismo texto
+static void testDocumentEdits(const shared_ptr<const CompiledGrammar> &language) {
+    string text;
+    for (int i = 0; i < 200; i++) text += (i ? ";" : "") + string("v") + to_string(i) + "=(" + to_string(i) + "+w)*2";
+    Document doc(language, text);
+    mt19937 rng(5);
+    const char *pieces[] = {";", ";", "(", ")", "x=1;", "+", "y"};
+    for (int step = 0; step < 2000; step++) {
+        size_t offset = rng() % (text.size() + 1);
+        size_t removed = rng() % 3 == 0 ? rng() % 4 : 0;
+        removed = min(removed, text.size() - offset);
+        string inserted = removed && rng() % 2 ? "" : pieces[rng() % 7];
+        // Saltos grandes de vez en cuando, para que el hueco se mueva lejos
+        if (step % 50 == 0) offset = step % 100 == 0 ? 0 : text.size();
+        text.replace(offset, removed, inserted);
+        doc.edit(offset, removed, inserted);
+        if (step % 20 != 0 && step != 1999) continue;
+        Document fresh(language, text);
+        bool same = doc.text() == text && doc.size() == text.size() && doc.statementCount() == fresh.statementCount()
+                    && doc.ok() == fresh.ok() && sameDiagnostics(doc.diagnostics(), fresh.diagnostics());
+        for (size_t i = 0; same && i < doc.statementCount(); i++) {
+            same = doc.beginOf(i) == fresh.beginOf(i) && doc.statementText(i) == fresh.statementText(i);
+        }
+        check(same, "Document editado == Document nuevo en el paso " + to_string(step));
+        if (!same) return;
+    }
+}
+
+// Con un perfil, BatchParser junta los ProfileTrace de sus workers: los totales
+// tienen que ser los de parsear los mismos documentos uno por uno
+static void testBatchProfile(const shared_ptr<const CompiledGrammar> &language) {
+    vector<string> texts = {"x=1;y=x+2*3", "print(x)", "x=;y=(1", "a=(b+c)*d;print(a-1)", "", "x=1)"};
+    for (int i = 0; i < 40; i++) texts.push_back("v" + to_string(i) + "=" + to_string(i) + "*(w+" + to_string(i) + ")");
+    vector<string_view> inputs(texts.begin(), texts.end());
+
+    ProfilingParser sequential(nullptr, language);
+    for (string_view input : inputs) {
+        Scanner scanner(input);
+        sequential.setScanner(&scanner);
+        sequential.parse();
+    }
+    const ParseProfile &expected = sequential.tracer().profile;
+
+    BatchParser batch(language, 3, 4);
+    ProfileAggregator aggregator;
+    batch.setProfile(&aggregator);
+    batch.parse(inputs);
+    ParseProfile merged = aggregator.snapshot();
+    check(merged.parses == expected.parses, "parseos del perfil de BatchParser");
+    check(merged.scan.tokens == expected.scan.tokens && merged.scan.bytes == expected.scan.bytes,
+          "tokens del perfil de BatchParser");
+    check(merged.matches == expected.matches && merged.ruleApplications == expected.ruleApplications,
+          "reglas del perfil de BatchParser");
+    check(merged.errors == expected.errors && merged.recoverySkips == expected.recoverySkips &&
+          merged.recoveryPops == expected.recoveryPops, "errores del perfil de BatchParser");
+
+    // Un segundo parse() suma, y sin perfil no se cuenta nada
+    batch.parse(inputs);
+    check(aggregator.snapshot().parses == 2 * expected.parses, "perfil acumulado de BatchParser");
+    batch.setProfile(nullptr);
+    batch.parse(inputs);
+    check(aggregator.snapshot().parses == 2 * expected.parses, "BatchParser sin perfil");
+}
+
+// El parser generado recursa una vez por parentesis: con un millon de niveles
+// tiene que cortar en MAX_DEPTH en vez de desbordar el stack, y el parser de
+// tabla (el que usa checkFile despues) decide el input igual
+static void testDeepNesting(const shared_ptr<const CompiledGrammar> &language) {
+    const size_t levels = 1000000;
+    string balanced = "x=" + string(levels, '(') + "1" + string(levels, ')');
+    string unbalanced = "x=" + string(levels, '(') + "1" + string(levels - 1, ')');
+    for (const string *input : {&balanced, &unbalanced}) {
+        bool valid = input == &balanced;
+        string what = valid ? "anidamiento profundo" : "anidamiento profundo sin cerrar";
+        Scanner scanner{string_view(*input)};
+        GeneratedParser fast(&scanner);
+        check(!fast.parse() && fast.depthExceeded(), what + ": el parser generado corta en MAX_DEPTH");
+        scanner.reset(*input);
+        QuietParser table(&scanner, language);
+        check(table.parse() == valid, what + ": el parser de tabla lo decide");
+    }
+
+    // Por debajo del limite el parser generado sigue decidiendo
+    string shallow = "x=" + string(100, '(') + "1" + string(100, ')');
+    Scanner scanner{string_view(shallow)};
+    GeneratedParser fast(&scanner);
+    check(fast.parse() && !fast.depthExceeded(), "anidamiento bajo el limite en el parser generado");
+}
+
+// A -> B A + | ID con B anulable: la recursion por izquierda queda detras de B,
+// GrammarTransform no la ve y la tabla tiene conflictos. parse() no puede usarla
+// (antes expandia A sin consumir input hasta quedarse sin memoria)
+static void testConflictedTable() {
+    Symbol id("ID", TERMINAL), num("NUM", TERMINAL), plus("+", TERMINAL);
+    Symbol a("A", NON_TERMINAL), b("B", NON_TERMINAL), eps("epsilon", EPSILON);
+    vector<ProdRule> rules = {{"A", {b, a, plus}}, {"A", {id}}, {"B", {eps}}, {"B", {num}}};
+    shared_ptr<const CompiledGrammar> language = CompiledGrammar::compile(Grammar(rules));
+    check(!language->conflicts().empty(), "A -> B A + | ID tiene conflictos");
+    Scanner scanner("a +");
+    QuietParser parser(&scanner, language);
+    check(!parser.parse(), "parse() con una tabla con conflictos");
+    const vector<Diagnostic> &diagnostics = parser.lastResult().diagnostics;
+    check(diagnostics.size() == 1 && diagnostics[0].kind == Diagnostic::GRAMMAR,
+          "diagnostico GRAMMAR con una tabla con conflictos");
+}
+
+static bool accepts(const shared_ptr<const CompiledGrammar> &language, const string &text) {
+    Scanner scanner{string_view(text)};
+    QuietParser parser(&scanner, language);
+    return parser.parse();
+}
+
+// GrammarTransform: las gramaticas en forma natural quedan LL(1) con el mismo
+// lenguaje y el mismo simbolo inicial, aunque todas sus alternativas sean
+// recursivas por izquierda (ahi el lenguaje es vacio y parse() lo rechaza)
+static void testGrammarTransform() {
+    Symbol id("ID", TERMINAL), num("NUM", TERMINAL), plus("+", TERMINAL), mul("*", TERMINAL);
+    Symbol lp("(", TERMINAL), rp(")", TERMINAL);
+    Symbol e("E", NON_TERMINAL), t("T", NON_TERMINAL), f("F", NON_TERMINAL);
+    vector<ProdRule> expr = {{"E", {e, plus, t}}, {"E", {t}}, {"T", {t, mul, f}}, {"T", {f}},
+                             {"F", {lp, e, rp}}, {"F", {id}}, {"F", {num}}};
+    shared_ptr<const CompiledGrammar> language = CompiledGrammar::compile(Grammar(expr));
+    const Grammar &g = language->grammar();
+    check(language->conflicts().empty(), "E -> E + T | T queda sin conflictos");
+    check(g.name(g.startSymbol()) == "E", "E sigue siendo el simbolo inicial");
+    for (string text : {"a", "a + 2 * (b + c)", "((1)) * x + y"}) {
+        check(accepts(language, text), "E acepta " + text);
+    }
+    for (string text : {"a +", "+ a", "a * * b", "(a"}) {
+        check(!accepts(language, text), "E rechaza " + text);
+    }
+
+    // Recursion indirecta S -> A NUM, A -> S +
+    Symbol s("S", NON_TERMINAL), a("A", NON_TERMINAL);
+    vector<ProdRule> indirect = {{"S", {a, num}}, {"S", {id}}, {"A", {s, plus}}, {"A", {lp}}};
+    language = CompiledGrammar::compile(Grammar(indirect));
+    check(language->conflicts().empty() && language->grammar().name(language->grammar().startSymbol()) == "S",
+          "S -> A NUM | ID, A -> S + | ( queda LL(1) desde S");
+    for (string text : {"a", "a + 1", "a + 1 + 2", "( 1 + 2"}) {
+        check(accepts(language, text), "S acepta " + text);
+    }
+    for (string text : {"a +", "1", "( a"}) {
+        check(!accepts(language, text), "S rechaza " + text);
+    }
+
+    // P -> P NUM no deriva ninguna cadena: P no puede desaparecer ni ceder el
+    // lugar de simbolo inicial a Q (antes quedaba Q, o ninguna regla)
+    Symbol p("P", NON_TERMINAL), q("Q", NON_TERMINAL);
+    for (const vector<ProdRule> &rules : {vector<ProdRule>{{"P", {p, num}}},
+                                          vector<ProdRule>{{"P", {p, num}}, {"Q", {id}}}}) {
+        language = CompiledGrammar::compile(Grammar(rules));
+        const Grammar &empty = language->grammar();
+        check(empty.name(empty.startSymbol()) == "P", "P -> P NUM sigue empezando en P");
+        check(!empty.productive(empty.startSymbol()), "P -> P NUM no es productivo");
+        Scanner scanner("a 1");
+        QuietParser parser(&scanner, language);
+        check(!parser.parse(), "parse() con un lenguaje vacio");
+        const vector<Diagnostic> &diagnostics = parser.lastResult().diagnostics;
+        check(diagnostics.size() == 1 && diagnostics[0].kind == Diagnostic::EMPTY,
+              "diagnostico EMPTY con un lenguaje vacio");
+    }
+
+    // Un no terminal no productivo fuera del inicial no cambia el resto
+    Symbol x("X", NON_TERMINAL);
+    language = CompiledGrammar::compile(Grammar({{"S", {id}}, {"S", {x}}, {"X", {x, num}}}));
+    check(accepts(language, "a") && !accepts(language, "1"), "S -> ID | X con X -> X NUM");
+}
+
+// LL(k): las decisiones aceptan lo mismo que la gramatica, una secuencia que no
+// esta en ninguna decision es un error que la recuperacion descarta, y un no
+// terminal inalcanzable (sin secuencias) no rompe la compilacion
+static void testLookahead() {
+    Symbol id("ID", TERMINAL), num("NUM", TERMINAL), assign("=", TERMINAL), semi(";", TERMINAL);
+    Symbol lp("(", TERMINAL), rp(")", TERMINAL), eps("epsilon", EPSILON);
+    Symbol s("S", NON_TERMINAL), a("A", NON_TERMINAL), b("B", NON_TERMINAL), e("E", NON_TERMINAL);
+    vector<ProdRule> ll2 = {{"S", {a, assign, e}}, {"S", {b, lp, e, rp}}, {"A", {id}}, {"B", {id}},
+                            {"E", {num}}, {"E", {id}}};
+    check(!CompiledGrammar::compile(Grammar(ll2))->conflicts().empty(), "S -> A = E | B ( E ) no es LL(1)");
+    shared_ptr<const CompiledGrammar> language = CompiledGrammar::compile(Grammar(ll2), 2);
+    check(language->conflicts().empty() && language->lookahead() == 2, "S -> A = E | B ( E ) es LL(2)");
+    for (string text : {"x = 1", "x = y", "f ( 1 )"}) {
+        check(accepts(language, text), "LL(2) acepta " + text);
+    }
+    for (string text : {"x", "x 1", "x ( 1", "x = = 1", "f ( 1 ) 2"}) {
+        check(!accepts(language, text), "LL(2) rechaza " + text);
+    }
+
+    // U no es alcanzable y su conflicto (U, ID) no tiene secuencias con que decidir
+    Symbol u("U", NON_TERMINAL), x("X", NON_TERMINAL), y("Y", NON_TERMINAL);
+    vector<ProdRule> unreachable = {{"S", {id}}, {"U", {x}}, {"U", {y}}, {"X", {id}}, {"Y", {id}}};
+    language = CompiledGrammar::compile(Grammar(unreachable), 2);
+    check(language->conflicts().size() == 1, "el conflicto de U inalcanzable sigue en conflicts()");
+
+    // Con ")" ninguna decision de NA coincide: antes se expandia la regla de la
+    // tabla LL(1), handleError sacaba el terminal faltante y se repetia sin fin
+    Symbol na("NA", NON_TERMINAL), nb("NB", NON_TERMINAL), nc("NC", NON_TERMINAL);
+    vector<ProdRule> miss = {{"NA", {nb}}, {"NA", {nc, semi, na}}, {"NA", {nb, nc, rp}}, {"NB", {lp, rp}},
+                             {"NC", {eps}}, {"NC", {id, nb}}, {"NC", {rp, na, num}}};
+    language = CompiledGrammar::compile(Grammar(miss), 3);
+    check(language->conflicts().empty(), "NA -> NB | NC ; NA | NB NC ) es LL(3)");
+    for (string text : {"( )", "( ) )", "; ( )", "x ( ) ; ( )", ") ( ) 1 ; ( )"}) {
+        check(accepts(language, text), "LL(3) acepta " + text);
+    }
+    for (string text : {")", ") )", "( ) ( )"}) {
+        check(!accepts(language, text), "LL(3) rechaza " + text);
+    }
+}
+
+// Escribe data en path con el checksum recalculado, asi solo la validacion de
+// la tabla puede rechazarla
+static void writeImage(string data, const string &path) {
+    GrammarImage::Header h;
+    memcpy(&h, data.data(), sizeof(h));
+    h.checksum = GrammarImage::checksum(h, string_view(data).substr(sizeof(h)));
+    memcpy(&data[0], &h, sizeof(h));
+    ofstream(path, ios::binary) << data;
+}
+
+// Cache en disco: un archivo con bytes cambiados se recompila, y una celda que
+// apunta a una regla que no corresponde no se carga aunque el checksum coincida
+static void testGrammarCache() {
+    vector<ProdRule> rules = generateGrammarRules();
+    uint64_t key = CompiledGrammar::cacheKey(rules);
+    string dir = "/tmp/tests-cache-" + to_string(getpid());
+    mkdir(dir.c_str(), 0755);
+    shared_ptr<const CompiledGrammar> compiled = CompiledGrammar::compileCached(rules, dir);
+    char name[48];
+    snprintf(name, sizeof(name), "/gramatica-%016llx.ll1", (unsigned long long) key);
+    string path = dir + name;
+    check(CompiledGrammar::load(path, key) != nullptr, "cargar la cache recien escrita");
+
+    ifstream in(path, ios::binary);
+    string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    GrammarImage image;
+    check(image.read(data, key), "leer la imagen de la cache");
+    size_t tableOffset = (const char *) image.table - data.data();
+
+    const Grammar &g = compiled->grammar();
+    int id = g.symbolId("ID");
+    auto cellOffset = [&](const string &nonTerm) {
+        return tableOffset + ((size_t) (g.symbolId(nonTerm) - g.numTerminals) * g.numTerminals + id) * sizeof(ParseCell);
+    };
+    auto ruleOf = [&](const string &lhs, const string &firstSymbol) {
+        for (int r : g.rulesFor(g.symbolId(lhs))) {
+            if (g.rules[r].rhs[0].value == firstSymbol) return r;
+        }
+        return -1;
+    };
+    // (SL, ID) -> P -> SL expande SL para siempre; (F, ID) -> F -> ( E ) es del
+    // no terminal correcto pero no predice ID y tambien crece sin consumir
+    vector<pair<size_t, ParseCell>> corruptions = {{cellOffset("SL"), ruleOf("P", "SL")},
+                                                   {cellOffset("F"), ruleOf("F", "(")},
+                                                   {cellOffset("SL"), -5}};
+    for (const auto &corruption : corruptions) {
+        string bad = data;
+        memcpy(&bad[corruption.first], &corruption.second, sizeof(ParseCell));
+        writeImage(bad, path);
+        check(CompiledGrammar::load(path, key) == nullptr,
+              "cache con la celda " + to_string(corruption.first) + " = " + to_string(corruption.second));
+    }
+    writeImage(data, path);
+    check(CompiledGrammar::load(path, key) != nullptr, "cache reescrita sin cambios");
+
+    // Sin recalcular el checksum: compileCached la recompila y la reescribe
+    string flipped = data;
+    flipped[data.size() / 2] ^= 1;
+    ofstream(path, ios::binary) << flipped;
+    check(CompiledGrammar::load(path, key) == nullptr, "cache con un bit cambiado");
+    check(CompiledGrammar::compileCached(rules, dir)->grammar().mapping == nullptr, "recompilar la cache danada");
+    check(CompiledGrammar::compileCached(rules, dir)->grammar().mapping != nullptr, "mapear la cache reescrita");
+
+    unlink(path.c_str());
+    rmdir(dir.c_str());
+}
+
+int main() {
+    shared_ptr<const CompiledGrammar> language = CompiledGrammar::compile(staticGrammar());
+    testStaticGrammar();
+    testParallelDiagnostics(language);
+    testDocumentUnbalanced(language);
+    testDocumentEdits(language);
+    testBatchProfile(language);
+    testGrammarCache();
+    testDeepNesting(language);
+    testConflictedTable();
+    testGrammarTransform();
+    testLookahead();
+    if (failures) {
+        cerr << failures << " pruebas fallaron" << endl;
+        return 1;
+    }
+    cout << "OK" << endl;
+    return 0;
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+#include "classes.cpp"
+
+using namespace std;
+
+// Backend del lenguaje de asignaciones y print: el compilador genera bytecode
+// durante el parseo LL(1) y la VM de stack lo ejecuta.
+
+// computed goto es una extension de GCC/Clang; sin ella la VM usa un switch
+#ifndef VM_COMPUTED_GOTO
+#if defined(__GNUC__)
+#define VM_COMPUTED_GOTO 1
+#else
+#define VM_COMPUTED_GOTO 0
+#endif
+#endif
+
+enum OpCode : uint8_t {
+    OP_PUSH,    // push constants[arg]
+    OP_LOAD,    // push slots[arg]
+    OP_STORE,   // slots[arg] = pop
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_PRINT,   // output += pop
+    OP_HALT
+};
+
+// Cada instruccion ocupa una palabra: opcode en los 8 bits bajos, argumento en los 24 altos
+inline uint32_t encodeOp(OpCode op, uint32_t arg = 0) {
+    return (uint32_t) op | (arg << 8);
+}
+
+struct Bytecode {
+    vector<uint32_t> code;
+    vector<int64_t> constants;
+    vector<string> slotNames;   // nombre de cada variable, solo para diagnosticos
+    uint32_t maxStack = 0;      // profundidad maxima del stack de operandos
+};
+
+// Politica de traza que actua como esquema de traduccion: escucha los match y
+// los fin de regla del parser y emite bytecode en postfijo. Los operadores
+// pendientes esperan en un stack hasta que su operando derecho se reduce:
+// '*' al reducir F, '+' y '-' al reducir T; '(' funciona como barrera.
+struct BytecodeCompiler {
+    static constexpr bool WANTS_REDUCE = true;
+    static constexpr bool WANTS_PROFILE = false;
+
+    enum RuleKind : uint8_t { OTHER, ASSIGN, PRINT, TERM, FACTOR_ID, FACTOR_NUM, FACTOR_PAREN };
+
+    Bytecode program;
+    bool failed = false;
+
+    void begin(const Grammar &g, string_view) {
+        program = Bytecode();
+        failed = false;
+        slots.clear();
+        constantIdx.clear();
+        pendingOps.clear();
+        targets.clear();
+        depth = 0;
+        classifyRules(g);
+    }
+
+    void match(const Grammar &, int, const Token &token) {
+        switch (token.type) {
+            case Token::ID:
+                lastSlot = slotFor(token.lexeme);
+                break;
+            case Token::NUM:
+                lastConstant = constantFor(token.lexeme);
+                break;
+            case Token::ASSIGN:
+                targets.push_back(lastSlot);
+                break;
+            case Token::PLUS:
+            case Token::MIN:
+            case Token::MUL:
+            case Token::LP:
+                pendingOps.push_back(token.type);
+                break;
+            case Token::RP:
+                if (!pendingOps.empty() && pendingOps.back() == Token::LP) pendingOps.pop_back();
+                break;
+            default:
+                break;
+        }
+    }
+
+    void reduce(const Grammar &, int ruleIdx, const Token &) {
+        if (failed) return;
+        switch (ruleKinds[ruleIdx]) {
+            case FACTOR_ID:
+                emit(OP_LOAD, lastSlot, +1);
+                reduceFactor();
+                break;
+            case FACTOR_NUM:
+                emit(OP_PUSH, lastConstant, +1);
+                reduceFactor();
+                break;
+            case FACTOR_PAREN:
+                reduceFactor();
+                break;
+            case TERM:
+                if (!pendingOps.empty() && (pendingOps.back() == Token::PLUS || pendingOps.back() == Token::MIN)) {
+                    emit(pendingOps.back() == Token::PLUS ? OP_ADD : OP_SUB, 0, -1);
+                    pendingOps.pop_back();
+                }
+                break;
+            case ASSIGN:
+                if (!targets.empty()) {
+                    emit(OP_STORE, targets.back(), -1);
+                    targets.pop_back();
+                }
+                break;
+            case PRINT:
+                emit(OP_PRINT, 0, -1);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void accept(const Token &, bool) {
+        emit(OP_HALT, 0, 0);
+    }
+
+    void step(const Grammar &, const vector<int> &, const Token &) {}
+    void apply(const Grammar &, int, const ProdRule &, const Token &) {}
+    void expected(const Grammar &, int, const Token &) { failed = true; }
+    void unexpected(const Token &) { failed = true; }
+    void skip(const Token &) {}
+    void pop(const Grammar &, int, const Token &) {}
+    void trailingInput(const Token &) { failed = true; }
+
+private:
+    vector<RuleKind> ruleKinds;
+    unordered_map<string_view, uint32_t> slots;
+    unordered_map<int64_t, uint32_t> constantIdx;
+    vector<Token::Type> pendingOps;
+    vector<uint32_t> targets;
+    uint32_t lastSlot = 0;
+    uint32_t lastConstant = 0;
+    int32_t depth = 0;
+
+    // Reconoce las reglas de la gramatica por su forma, no por su indice
+    void classifyRules(const Grammar &g) {
+        ruleKinds.assign(g.rules.size(), OTHER);
+        for (size_t r = 0; r < g.rules.size(); r++) {
+            const ProdRule &rule = g.rules[r];
+            string shape = rule.lhs + " ->";
+            for (const Symbol &sym : rule.rhs) shape += " " + sym.value;
+            if (shape == "S -> ID = E") ruleKinds[r] = ASSIGN;
+            else if (shape == "S -> print ( E )") ruleKinds[r] = PRINT;
+            else if (shape == "T -> F T'") ruleKinds[r] = TERM;
+            else if (shape == "F -> ID") ruleKinds[r] = FACTOR_ID;
+            else if (shape == "F -> NUM") ruleKinds[r] = FACTOR_NUM;
+            else if (shape == "F -> ( E )") ruleKinds[r] = FACTOR_PAREN;
+        }
+    }
+
+    void reduceFactor() {
+        if (!pendingOps.empty() && pendingOps.back() == Token::MUL) {
+            emit(OP_MUL, 0, -1);
+            pendingOps.pop_back();
+        }
+    }
+
+    void emit(OpCode op, uint32_t arg, int stackEffect) {
+        if (arg >= (1u << 24)) failed = true;   // no cabe en el argumento de 24 bits
+        program.code.push_back(encodeOp(op, arg));
+        depth += stackEffect;
+        if (depth > (int32_t) program.maxStack) program.maxStack = depth;
+    }
+
+    // Las variables se resuelven a un slot una sola vez, al compilar; la clave
+    // apunta al input, que vive mientras dura el parseo
+    uint32_t slotFor(string_view name) {
+        auto it = slots.find(name);
+        if (it != slots.end()) return it->second;
+        uint32_t slot = (uint32_t) program.slotNames.size();
+        program.slotNames.emplace_back(name);
+        slots.emplace(name, slot);
+        return slot;
+    }
+
+    uint32_t constantFor(string_view digits) {
+        int64_t value = 0;
+        for (char c : digits) value = (int64_t) ((uint64_t) value * 10 + (uint64_t) (c - '0'));
+        auto it = constantIdx.find(value);
+        if (it != constantIdx.end()) return it->second;
+        uint32_t idx = (uint32_t) program.constants.size();
+        program.constants.push_back(value);
+        constantIdx.emplace(value, idx);
+        return idx;
+    }
+};
+
+// Compila source a bytecode; devuelve false si hubo errores de sintaxis
+inline bool compileProgram(shared_ptr<const CompiledGrammar> language, string_view source, Bytecode &out) {
+    Scanner scanner(source);
+    BasicParser<BytecodeCompiler> parser(&scanner, std::move(language));
+    parser.parse();
+    if (parser.tracer().failed) return false;
+    out = std::move(parser.tracer().program);
+    return true;
+}
+
+// VM de stack. Las variables viven en slots indexados; la aritmetica es en
+// complemento a dos (sin comportamiento indefinido al desbordar).
+class VM {
+    private:
+        vector<int64_t> slots;
+        vector<int64_t> stack;
+
+    public:
+        vector<int64_t> output;   // valores impresos por print
+
+        // Ejecuta el programa y devuelve la cantidad de instrucciones ejecutadas
+        uint64_t run(const Bytecode &program) {
+            slots.assign(program.slotNames.size(), 0);
+            stack.assign(program.maxStack + 1, 0);
+
+            const uint32_t *pc = program.code.data();
+            const int64_t *constants = program.constants.data();
+            int64_t *vars = slots.data();
+            int64_t *sp = stack.data();   // apunta al ultimo elemento; stack[0] no se usa
+            uint32_t word;
+
+#if VM_COMPUTED_GOTO
+            // Despacho con computed goto: un salto indirecto por instruccion
+            static const void *labels[] = {&&L_PUSH, &&L_LOAD, &&L_STORE, &&L_ADD, &&L_SUB, &&L_MUL, &&L_PRINT, &&L_HALT};
+#define VM_DISPATCH() do { word = *pc++; goto *labels[word & 0xFF]; } while (0)
+#define VM_CASE(op) L_##op
+            VM_DISPATCH();
+#else
+#define VM_DISPATCH() continue
+#define VM_CASE(op) case OP_##op
+            for (;;) {
+                word = *pc++;
+                switch (word & 0xFF) {
+#endif
+            VM_CASE(PUSH):
+                *++sp = constants[word >> 8];
+                VM_DISPATCH();
+            VM_CASE(LOAD):
+                *++sp = vars[word >> 8];
+                VM_DISPATCH();
+            VM_CASE(STORE):
+                vars[word >> 8] = *sp--;
+                VM_DISPATCH();
+            VM_CASE(ADD):
+                sp[-1] = (int64_t) ((uint64_t) sp[-1] + (uint64_t) sp[0]);
+                sp--;
+                VM_DISPATCH();
+            VM_CASE(SUB):
+                sp[-1] = (int64_t) ((uint64_t) sp[-1] - (uint64_t) sp[0]);
+                sp--;
+                VM_DISPATCH();
+            VM_CASE(MUL):
+                sp[-1] = (int64_t) ((uint64_t) sp[-1] * (uint64_t) sp[0]);
+                sp--;
+                VM_DISPATCH();
+            VM_CASE(PRINT):
+                output.push_back(*sp--);
+                VM_DISPATCH();
+            VM_CASE(HALT):
+#if !VM_COMPUTED_GOTO
+                break;
+                }
+                break;
+            }
+#endif
+#undef VM_DISPATCH
+#undef VM_CASE
+            return pc - program.code.data();
+        }
+
+        int64_t slot(uint32_t idx) const {
+            return slots[idx];
+        }
+};
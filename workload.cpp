@@ -0,0 +1,135 @@
+#pragma once
+
+#include <random>
+#include "classes.cpp"
+
+using namespace std;
+
+// Generador de programas aleatorios derivados de una Grammar. Expande desde el
+// simbolo inicial con un stack explicito; la profundidad solo crece en las
+// posiciones que no son la ultima de la RHS, asi las listas recursivas por la
+// cola (SL', E', T') no cuentan como anidamiento y si los parentesis de F.
+struct WorkloadOptions {
+    size_t targetTokens = 100000;   // se deja de alargar el programa al llegar
+    int maxDepth = 8;               // desde aca solo se eligen las reglas mas cortas
+    double errorRate = 0;           // probabilidad de mutar cada token (programas invalidos)
+};
+
+struct GeneratedProgram {
+    string text;
+    size_t tokens = 0;
+    size_t mutations = 0;
+};
+
+class ProgramGenerator {
+    private:
+        const Grammar &grammar;
+        mt19937 rng;
+        // Por no terminal, la regla con la derivacion mas baja; asegura que se termina
+        vector<int> shortestRule;
+
+        // Altura minima de derivacion de cada simbolo como punto fijo
+        void computeShortestRules() {
+            const int INF = 1 << 30;
+            vector<int> height(grammar.symbolCount(), INF);
+            for (int t = 0; t < grammar.numTerminals; t++) height[t] = 0;
+            shortestRule.assign(grammar.symbolCount(), -1);
+            for (bool changed = true; changed;) {
+                changed = false;
+                for (int r = 0; r < (int) grammar.rules.size(); r++) {
+                    const ProdRule &rule = grammar.rules[r];
+                    int h = 0;
+                    for (const Symbol &sym : rule.rhs) {
+                        if (sym.type != EPSILON) h = max(h, height[sym.id]);
+                    }
+                    if (h < INF && h + 1 < height[rule.lhsId]) {
+                        height[rule.lhsId] = h + 1;
+                        shortestRule[rule.lhsId] = r;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        string lexemeFor(int terminal) {
+            const string &name = grammar.name(terminal);
+            if (name == "ID") {
+                static const char *names[] = {"x", "y", "total", "accumulatedValue", "i", "tmp42"};
+                return names[rng() % 6] + (rng() % 2 ? to_string(rng() % 16) : string());
+            }
+            if (name == "NUM") return to_string(rng() % 100000);
+            return name;
+        }
+
+        // Pega el lexema; separa con un espacio dos lexemas alfanumericos seguidos
+        static void append(string &out, const string &lexeme) {
+            if (!out.empty() && isalnum((unsigned char) out.back()) && isalnum((unsigned char) lexeme[0])) out += ' ';
+            out += lexeme;
+            if (lexeme == ";") out += '\n';
+        }
+
+        void emit(GeneratedProgram &program, int terminal, double errorRate) {
+            program.tokens++;
+            if (errorRate <= 0 || uniform_real_distribution<double>(0, 1)(rng) >= errorRate) {
+                append(program.text, lexemeFor(terminal));
+                return;
+            }
+            program.mutations++;
+            switch (rng() % 4) {
+                case 0:   // se pierde el token
+                    break;
+                case 1:   // token duplicado
+                    append(program.text, lexemeFor(terminal));
+                    append(program.text, lexemeFor(terminal));
+                    break;
+                case 2:   // otro terminal cualquiera
+                    append(program.text, lexemeFor(1 + rng() % (grammar.numTerminals - 1)));
+                    break;
+                default:  // caracter que el scanner no reconoce
+                    append(program.text, lexemeFor(terminal));
+                    program.text += '@';
+                    break;
+            }
+        }
+
+    public:
+        ProgramGenerator(const Grammar &g, unsigned seed) : grammar(g), rng(seed) {
+            computeShortestRules();
+        }
+
+        GeneratedProgram generate(const WorkloadOptions &options) {
+            GeneratedProgram program;
+            vector<pair<int, int>> pending = {{grammar.startSymbol(), 0}};   // simbolo, profundidad
+            while (!pending.empty()) {
+                auto [symbol, depth] = pending.back();
+                pending.pop_back();
+                if (grammar.isTerminal(symbol)) {
+                    emit(program, symbol, options.errorRate);
+                    continue;
+                }
+
+                const vector<int> &rules = grammar.rulesFor(symbol);
+                int ruleIdx;
+                if (program.tokens >= options.targetTokens || depth >= options.maxDepth) {
+                    ruleIdx = shortestRule[symbol];
+                } else if (depth == 0) {
+                    // La lista de nivel superior se alarga hasta llegar al tamano pedido
+                    vector<int> growing;
+                    for (int r : rules) {
+                        if (grammar.rules[r].rhs[0].type != EPSILON) growing.push_back(r);
+                    }
+                    ruleIdx = growing.empty() ? shortestRule[symbol] : growing[rng() % growing.size()];
+                } else {
+                    ruleIdx = rules[rng() % rules.size()];
+                }
+                if (ruleIdx < 0) continue;   // no terminal sin derivaciones finitas
+
+                const vector<Symbol> &rhs = grammar.rules[ruleIdx].rhs;
+                if (rhs[0].type == EPSILON) continue;
+                for (int i = (int) rhs.size() - 1; i >= 0; i--) {
+                    pending.emplace_back(rhs[i].id, i + 1 == (int) rhs.size() ? depth : depth + 1);
+                }
+            }
+            return program;
+        }
+};